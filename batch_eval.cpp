@@ -0,0 +1,463 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_HAS_X86_KERNELS 1
+#else
+#define BATCH_HAS_X86_KERNELS 0
+#endif
+
+#include "batch_eval.h"
+#include "logic_functions.h"
+#include "fast_math.h"
+
+typedef void (*binary_kernel)(const double* left, const double* right, double* out, size_t count);
+typedef void (*unary_kernel) (const double* argument, double* out, size_t count);
+
+struct arithmetic_kernels
+{
+    const char*   name;
+    binary_kernel add;
+    binary_kernel sub;
+    binary_kernel mul;
+    binary_kernel div;
+};
+
+struct transcendental_kernels
+{
+    unary_kernel sin;
+    unary_kernel cos;
+    unary_kernel exp;
+    unary_kernel ln;
+};
+
+static std::atomic<batch_math_mode> current_math_mode(BATCH_MATH_EXACT);
+
+// ==================== СКАЛЯРНЫЕ ЯДРА ====================
+
+static void scalar_add(const double* left, const double* right, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = left[i] + right[i];
+}
+
+
+static void scalar_sub(const double* left, const double* right, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = left[i] - right[i];
+}
+
+
+static void scalar_mul(const double* left, const double* right, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = left[i] * right[i];
+}
+
+
+static void scalar_div(const double* left, const double* right, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = left[i] / right[i];
+}
+
+// ==================== AVX2 / AVX-512 ЯДРА ====================
+
+#if BATCH_HAS_X86_KERNELS
+
+#define DEFINE_AVX2_KERNEL(name, intrinsic, scalar_op)                               \
+    __attribute__((target("avx2")))                                                  \
+    static void name(const double* left, const double* right, double* out, size_t count) \
+    {                                                                                \
+        size_t i = 0;                                                                \
+        for (; i + 4 <= count; i += 4)                                               \
+        {                                                                            \
+            __m256d a = _mm256_loadu_pd(left  + i);                                  \
+            __m256d b = _mm256_loadu_pd(right + i);                                  \
+            _mm256_storeu_pd(out + i, intrinsic(a, b));                              \
+        }                                                                            \
+        for (; i < count; i++)                                                       \
+            out[i] = left[i] scalar_op right[i];                                     \
+    }
+
+#define DEFINE_AVX512_KERNEL(name, intrinsic, scalar_op)                             \
+    __attribute__((target("avx512f")))                                               \
+    static void name(const double* left, const double* right, double* out, size_t count) \
+    {                                                                                \
+        size_t i = 0;                                                                \
+        for (; i + 8 <= count; i += 8)                                               \
+        {                                                                            \
+            __m512d a = _mm512_loadu_pd(left  + i);                                  \
+            __m512d b = _mm512_loadu_pd(right + i);                                  \
+            _mm512_storeu_pd(out + i, intrinsic(a, b));                              \
+        }                                                                            \
+        for (; i < count; i++)                                                       \
+            out[i] = left[i] scalar_op right[i];                                     \
+    }
+
+DEFINE_AVX2_KERNEL(avx2_add, _mm256_add_pd, +)
+DEFINE_AVX2_KERNEL(avx2_sub, _mm256_sub_pd, -)
+DEFINE_AVX2_KERNEL(avx2_mul, _mm256_mul_pd, *)
+DEFINE_AVX2_KERNEL(avx2_div, _mm256_div_pd, /)
+
+DEFINE_AVX512_KERNEL(avx512_add, _mm512_add_pd, +)
+DEFINE_AVX512_KERNEL(avx512_sub, _mm512_sub_pd, -)
+DEFINE_AVX512_KERNEL(avx512_mul, _mm512_mul_pd, *)
+DEFINE_AVX512_KERNEL(avx512_div, _mm512_div_pd, /)
+
+#undef DEFINE_AVX2_KERNEL
+#undef DEFINE_AVX512_KERNEL
+
+#endif // BATCH_HAS_X86_KERNELS
+
+
+static const arithmetic_kernels* select_arithmetic_kernels()
+{
+    static const arithmetic_kernels scalar_kernels = {"scalar", scalar_add, scalar_sub, scalar_mul, scalar_div};
+
+#if BATCH_HAS_X86_KERNELS
+    static const arithmetic_kernels avx2_kernels   = {"avx2",   avx2_add,   avx2_sub,   avx2_mul,   avx2_div};
+    static const arithmetic_kernels avx512_kernels = {"avx512", avx512_add, avx512_sub, avx512_mul, avx512_div};
+
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+        return &avx512_kernels;
+
+    if (__builtin_cpu_supports("avx2"))
+        return &avx2_kernels;
+#endif
+
+    return &scalar_kernels;
+}
+
+
+static const arithmetic_kernels* get_arithmetic_kernels()
+{
+    static const arithmetic_kernels* selected = select_arithmetic_kernels();
+
+    return selected;
+}
+
+// ==================== ТРАНСЦЕНДЕНТНЫЕ ФУНКЦИИ ====================
+
+// Точный режим: поэлементно через libm, векторные приближения - в fast_math.cpp
+
+static void block_sin(const double* argument, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = sin(argument[i]);
+}
+
+
+static void block_cos(const double* argument, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = cos(argument[i]);
+}
+
+
+static void block_exp(const double* argument, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = exp(argument[i]);
+}
+
+
+static void block_ln(const double* argument, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = log(argument[i]);
+}
+
+
+static const transcendental_kernels* get_transcendental_kernels(batch_math_mode mode)
+{
+    static const transcendental_kernels libm_kernels = {block_sin, block_cos, block_exp, block_ln};
+    static const transcendental_kernels fast_kernels = {fast_sin_block, fast_cos_block, fast_exp_block, fast_ln_block};
+
+    return (mode == BATCH_MATH_FAST) ? &fast_kernels : &libm_kernels;
+}
+
+
+static void block_pow(const double* base, const double* exponent, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = pow(base[i], exponent[i]);
+}
+
+
+// Операции reduced_pow_as в том же порядке, но целыми блоками через ядра умножения и деления:
+// показатель общий для инструкции, поэтому ветвления идут по его битам, а не по точкам
+static void block_reduced_pow(const arithmetic_kernels* kernels, const double* base, double exponent,
+                              double* out, size_t count)
+{
+    double square[BATCH_BLOCK_SIZE];
+    double magnitude = fabs(exponent);
+    double whole     = floor(magnitude);
+
+    for (size_t i = 0; i < count; i++)
+        out[i] = 1.0;
+    memcpy(square, base, count * sizeof(double));
+
+    for (unsigned power = (unsigned)whole; power != 0; )
+    {
+        if (power & 1u)
+            kernels -> mul(out, square, out, count);
+
+        power >>= 1;
+        if (power != 0)
+            kernels -> mul(square, square, square, count);
+    }
+
+    if (magnitude > whole)
+    {
+        for (size_t i = 0; i < count; i++)
+            square[i] = sqrt(base[i]);
+        kernels -> mul(out, square, out, count);
+    }
+
+    if (exponent < 0)
+    {
+        for (size_t i = 0; i < count; i++)
+            square[i] = 1.0;
+        kernels -> div(square, out, out, count);
+    }
+}
+
+// ==================== ФЛАГИ ОШИБОК ДЛЯ РЕЖИМА IEEE ====================
+
+static void flag_division_by_zero(const double* divisor, point_error_mask* errors, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        errors[i] |= (point_error_mask)((fabs(divisor[i]) < ZERO_EPSILON) * POINT_ERROR_DIVISION_BY_ZERO);
+}
+
+
+static void flag_ln_domain(const double* argument, point_error_mask* errors, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        errors[i] |= (point_error_mask)(!(argument[i] > 0) * POINT_ERROR_LN_DOMAIN);
+}
+
+// ==================== ВЫЧИСЛЕНИЕ БЛОКА ====================
+
+// errors == NULL - проверяемый режим: первая ошибка прерывает вычисление;
+// иначе inf/NaN распространяются, а ошибки копятся в маске точки без ветвлений
+static tree_error_type evaluate_block(const compiled_expression* expr, const arithmetic_kernels* kernels,
+                                      const transcendental_kernels* transcendentals,
+                                      const double* const* variables, size_t start, size_t count,
+                                      double* scratch, point_error_mask* errors)
+{
+    for (size_t i = 0; i < expr -> size; i++)
+    {
+        const instruction_t* instruction = &expr -> instructions[i];
+
+        double* out = scratch + i * BATCH_BLOCK_SIZE;
+        const double* left  = (instruction -> left  != NO_OPERAND) ?
+                              scratch + (size_t)instruction -> left  * BATCH_BLOCK_SIZE : NULL;
+        const double* right = (instruction -> right != NO_OPERAND) ?
+                              scratch + (size_t)instruction -> right * BATCH_BLOCK_SIZE : NULL;
+
+        switch (instruction -> code)
+        {
+            case INSTR_NUM:
+                break;  // заполнены один раз в evaluate_batch_range
+            case INSTR_VAR:
+                memcpy(out, variables[instruction -> variable] + start, count * sizeof(double));
+                break;
+            case INSTR_ADD:
+                kernels -> add(left, right, out, count);
+                break;
+            case INSTR_SUB:
+                kernels -> sub(left, right, out, count);
+                break;
+            case INSTR_MUL:
+                kernels -> mul(left, right, out, count);
+                break;
+            case INSTR_DIV:
+                if (errors != NULL)
+                    flag_division_by_zero(right, errors, count);
+                else
+                    for (size_t j = 0; j < count; j++)
+                        if (is_zero(right[j]))
+                            return TREE_ERROR_DIVISION_BY_ZERO;
+                kernels -> div(left, right, out, count);
+                break;
+            case INSTR_SIN:
+                transcendentals -> sin(right, out, count);
+                break;
+            case INSTR_COS:
+                transcendentals -> cos(right, out, count);
+                break;
+            case INSTR_POW:
+                block_pow(left, right, out, count);
+                break;
+            case INSTR_POWI:
+                block_reduced_pow(kernels, left, instruction -> value, out, count);
+                break;
+            case INSTR_LN:
+                if (errors != NULL)
+                    flag_ln_domain(right, errors, count);
+                else
+                    for (size_t j = 0; j < count; j++)
+                        if (right[j] <= 0)
+                            return TREE_ERROR_YCHI_MATAN;
+                transcendentals -> ln(right, out, count);
+                break;
+            case INSTR_EXP:
+                transcendentals -> exp(right, out, count);
+                break;
+            default:
+                return TREE_ERROR_UNKNOWN_OPERATION;
+        }
+    }
+
+    return TREE_ERROR_NO;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+size_t batch_scratch_size(const compiled_expression* expr)
+{
+    assert(expr != NULL);
+
+    return expr -> size * BATCH_BLOCK_SIZE;
+}
+
+
+const char* batch_kernels_name()
+{
+    return get_arithmetic_kernels() -> name;
+}
+
+
+void batch_set_math_mode(batch_math_mode mode)
+{
+    current_math_mode.store(mode);
+}
+
+
+batch_math_mode batch_get_math_mode()
+{
+    return current_math_mode.load();
+}
+
+
+static tree_error_type run_batch_range(const compiled_expression* expr, const double* const* variables,
+                                       size_t begin, size_t end, double* results, double* scratch,
+                                       point_error_mask* errors)
+{
+    if (expr == NULL || results == NULL || scratch == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (expr -> result == NO_OPERAND)
+        return TREE_ERROR_NULL_PTR;
+
+    if (expr -> number_of_variables > 0 && variables == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    const arithmetic_kernels*     kernels         = get_arithmetic_kernels();
+    const transcendental_kernels* transcendentals = get_transcendental_kernels(current_math_mode.load());
+
+    for (size_t i = 0; i < expr -> size; i++)
+    {
+        if (expr -> instructions[i].code != INSTR_NUM)
+            continue;
+
+        double* out = scratch + i * BATCH_BLOCK_SIZE;
+        for (size_t j = 0; j < BATCH_BLOCK_SIZE; j++)
+            out[j] = expr -> instructions[i].value;
+    }
+
+    const double* result_block = scratch + (size_t)expr -> result * BATCH_BLOCK_SIZE;
+
+    for (size_t start = begin; start < end; start += BATCH_BLOCK_SIZE)
+    {
+        size_t count = (end - start < BATCH_BLOCK_SIZE) ? end - start : BATCH_BLOCK_SIZE;
+
+        point_error_mask* block_errors = NULL;
+        if (errors != NULL)
+        {
+            block_errors = errors + start;
+            memset(block_errors, 0, count * sizeof(point_error_mask));
+        }
+
+        tree_error_type error = evaluate_block(expr, kernels, transcendentals, variables, start, count, scratch, block_errors);
+        if (error != TREE_ERROR_NO)
+            return error;
+
+        memcpy(results + start, result_block, count * sizeof(double));
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+tree_error_type evaluate_batch_range(const compiled_expression* expr, const double* const* variables,
+                                     size_t begin, size_t end, double* results, double* scratch)
+{
+    return run_batch_range(expr, variables, begin, end, results, scratch, NULL);
+}
+
+
+tree_error_type evaluate_batch_range_ieee(const compiled_expression* expr, const double* const* variables,
+                                          size_t begin, size_t end, double* results, double* scratch,
+                                          point_error_mask* errors)
+{
+    if (errors == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    return run_batch_range(expr, variables, begin, end, results, scratch, errors);
+}
+
+
+tree_error_type evaluate_batch(const compiled_expression* expr, const double* const* variables,
+                               size_t count, double* results)
+{
+    if (expr == NULL || results == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    double* scratch = (double*)calloc(batch_scratch_size(expr), sizeof(double));
+    if (scratch == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    tree_error_type error = evaluate_batch_range(expr, variables, 0, count, results, scratch);
+
+    free(scratch);
+    return error;
+}
+
+
+tree_error_type evaluate_batch_ieee(const compiled_expression* expr, const double* const* variables,
+                                    size_t count, double* results, point_error_mask* errors)
+{
+    if (expr == NULL || results == NULL || errors == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    double* scratch = (double*)calloc(batch_scratch_size(expr), sizeof(double));
+    if (scratch == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    tree_error_type error = evaluate_batch_range_ieee(expr, variables, 0, count, results, scratch, errors);
+
+    free(scratch);
+    return error;
+}
+
+
+tree_error_type point_error_to_tree_error(point_error_mask error)
+{
+    if (error & POINT_ERROR_DIVISION_BY_ZERO)
+        return TREE_ERROR_DIVISION_BY_ZERO;
+
+    if (error & POINT_ERROR_LN_DOMAIN)
+        return TREE_ERROR_YCHI_MATAN;
+
+    return TREE_ERROR_NO;
+}
@@ -0,0 +1,48 @@
+#ifndef BATCH_EVAL_H_
+#define BATCH_EVAL_H_
+
+#include <stddef.h>
+
+#include "tree_error_types.h"
+#include "compiled_expression.h"
+
+const size_t BATCH_BLOCK_SIZE = 256;
+
+typedef unsigned char point_error_mask;
+
+// BATCH_MATH_EXACT - SIMD-ядрами считаются только +, -, * и /, а sin/cos/exp/ln/pow
+// вычисляются поэлементно через libm, поэтому результат совпадает с evaluate_tree.
+// BATCH_MATH_FAST - приближённые векторные sin/cos/exp/ln из fast_math.h (ошибки описаны там);
+// режим общий для процесса и действует на все последующие вызовы evaluate_batch*
+enum batch_math_mode
+{
+    BATCH_MATH_EXACT,
+    BATCH_MATH_FAST
+};
+
+enum point_error_flag
+{
+    POINT_ERROR_DIVISION_BY_ZERO = 1 << 0,
+    POINT_ERROR_LN_DOMAIN        = 1 << 1
+};
+
+// variables[i] - массив значений i-й переменной из variable_table (structure of arrays)
+size_t          batch_scratch_size  (const compiled_expression* expr);
+const char*     batch_kernels_name  ();
+void            batch_set_math_mode (batch_math_mode mode);
+batch_math_mode batch_get_math_mode ();
+tree_error_type evaluate_batch_range(const compiled_expression* expr, const double* const* variables,
+                                     size_t begin, size_t end, double* results, double* scratch);
+tree_error_type evaluate_batch      (const compiled_expression* expr, const double* const* variables,
+                                     size_t count, double* results);
+
+// Режим IEEE: без проверок в узлах, inf/NaN распространяются до результата,
+// а errors[i] получает маску point_error_flag для i-й точки
+tree_error_type evaluate_batch_range_ieee(const compiled_expression* expr, const double* const* variables,
+                                          size_t begin, size_t end, double* results, double* scratch,
+                                          point_error_mask* errors);
+tree_error_type evaluate_batch_ieee      (const compiled_expression* expr, const double* const* variables,
+                                          size_t count, double* results, point_error_mask* errors);
+tree_error_type point_error_to_tree_error(point_error_mask error);
+
+#endif // BATCH_EVAL_H_
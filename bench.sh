@@ -0,0 +1,7 @@
+#!/bin/bash
+
+files="benchmark.cpp dump.cpp io_diff.cpp latex_dump.cpp logic_functions.cpp operations.cpp tree_base.cpp user_interface.cpp variable_parse.cpp new_input.cpp processing_diff.cpp compiled_expression.cpp batch_eval.cpp jit_codegen.cpp thread_pool.cpp parallel_eval.cpp incremental_eval.cpp sweep_eval.cpp power_reduction.cpp fast_math.cpp reverse_ad.cpp forward_ad.cpp taylor_eval.cpp symbolic_derivatives.cpp rewrite_rules.cpp egraph.cpp like_terms.cpp polynomial_form.cpp"
+
+flags="-std=c++17 -O2 -Wall -Wextra"
+
+g++ -I./include $files -o benchmark $flags -ldl -pthread && ./benchmark
@@ -0,0 +1,1325 @@
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <thread>
+
+#include "new_input.h"
+#include "tree_base.h"
+#include "batch_eval.h"
+#include "jit_codegen.h"
+#include "thread_pool.h"
+#include "parallel_eval.h"
+#include "sweep_eval.h"
+#include "incremental_eval.h"
+#include "typed_eval.h"
+#include "fast_math.h"
+#include "reverse_ad.h"
+#include "forward_ad.h"
+#include "taylor_eval.h"
+#include "symbolic_derivatives.h"
+#include "egraph.h"
+#include "polynomial_form.h"
+#include "operations.h"
+#include "variable_parse.h"
+#include "compiled_expression.h"
+
+const size_t BENCHMARK_POINTS = 1000000;
+const size_t DERIVATIVE_QUERIES = 10000;
+const size_t SYMBOLIC_ORDER     = 4;
+const size_t TAYLOR_ORDER       = 16;
+const size_t WIDE_SUM_TERMS     = 20000;
+const size_t EGRAPH_ORDER       = 3;
+
+// допустимое относительное расхождение частных производных обратного и прямого режима
+const double GRADIENT_TOLERANCE = 1e-12;
+
+const char* const BENCHMARK_EXPRESSIONS[] = {
+    "sin(x)+5*x-11*ln(5*x+7)-10000+10000-5000+10*10+4914$",
+    "x^3+2*x^2-x/y+cos(x*y)$",
+    "(x+1)*(x-1)/(x*x+1)+exp(y)*y$",
+    "x^4-3*x^3*y^2+x^5/y^2+7*y^6-x^2*y$"
+};
+
+const size_t NUMBER_OF_BENCHMARK_EXPRESSIONS = sizeof(BENCHMARK_EXPRESSIONS) / sizeof(BENCHMARK_EXPRESSIONS[0]);
+
+struct benchmark_case
+{
+    tree_t          tree;
+    variable_table  var_table;
+    double**        variables;  // structure of arrays, по массиву на переменную
+    size_t          points;
+};
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static double get_time_seconds()
+{
+    struct timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+
+static double max_difference(const double* expected, const double* actual, size_t count)
+{
+    double max_diff = 0.0;
+    for (size_t i = 0; i < count; i++)
+        if (fabs(expected[i] - actual[i]) > max_diff)
+            max_diff = fabs(expected[i] - actual[i]);
+
+    return max_diff;
+}
+
+
+static double ulp_distance(double expected, double actual)
+{
+    if (isnan(expected) && isnan(actual))
+        return 0.0;
+
+    int64_t expected_bits = 0, actual_bits = 0;
+    memcpy(&expected_bits, &expected, sizeof(expected_bits));
+    memcpy(&actual_bits,   &actual,   sizeof(actual_bits));
+
+    // отрицательные числа переворачиваются, чтобы порядок битов совпал с порядком чисел
+    if (expected_bits < 0) expected_bits = INT64_MIN - expected_bits;
+    if (actual_bits   < 0) actual_bits   = INT64_MIN - actual_bits;
+
+    uint64_t distance = (expected_bits > actual_bits) ? (uint64_t)expected_bits - (uint64_t)actual_bits
+                                                      : (uint64_t)actual_bits   - (uint64_t)expected_bits;
+
+    return (double)distance;
+}
+
+
+static void destroy_benchmark_case(benchmark_case* bench)
+{
+    if (bench -> variables != NULL)
+    {
+        for (int i = 0; i < bench -> var_table.number_of_variables; i++)
+            free(bench -> variables[i]);
+        free(bench -> variables);
+        bench -> variables = NULL;
+    }
+
+    tree_destructor(&bench -> tree);
+    destroy_variable_table(&bench -> var_table);
+}
+
+
+static tree_error_type create_benchmark_case(benchmark_case* bench, const char* expression, size_t points)
+{
+    tree_constructor(&bench -> tree);
+    init_variable_table(&bench -> var_table);
+    bench -> variables = NULL;
+    bench -> points    = points;
+
+    const char* ptr = expression;
+    bench -> tree.root = get_G(&ptr, &bench -> var_table);
+    if (bench -> tree.root == NULL)
+        return TREE_ERROR_FORMAT;
+
+    bench -> tree.size = count_tree_nodes(bench -> tree.root);
+
+    int number_of_variables = bench -> var_table.number_of_variables;
+    bench -> variables = (double**)calloc((size_t)number_of_variables + 1, sizeof(double*));
+    if (bench -> variables == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    for (int i = 0; i < number_of_variables; i++)
+    {
+        bench -> variables[i] = (double*)calloc(points, sizeof(double));
+        if (bench -> variables[i] == NULL)
+            return TREE_ERROR_ALLOCATION;
+
+        for (size_t j = 0; j < points; j++)
+            bench -> variables[i][j] = 0.5 + (double)(i + 1) * (double)j / (double)points;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+// ==================== БЕНЧМАРКИ ====================
+
+static void benchmark_batch_evaluation(benchmark_case* bench, const char* expression)
+{
+    compiled_expression expr = {};
+    compiled_expression_constructor(&expr);
+
+    if (compile_tree(&bench -> tree, &bench -> var_table, &expr) != TREE_ERROR_NO)
+    {
+        printf("  failed to compile expression\n");
+        return;
+    }
+
+    double* expected = (double*)calloc(bench -> points, sizeof(double));
+    double* results  = (double*)calloc(bench -> points, sizeof(double));
+    if (expected == NULL || results == NULL)
+    {
+        free(expected);
+        free(results);
+        compiled_expression_destructor(&expr);
+        return;
+    }
+
+    double start = get_time_seconds();
+    for (size_t j = 0; j < bench -> points; j++)
+    {
+        for (int i = 0; i < bench -> var_table.number_of_variables; i++)
+            set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, bench -> variables[i][j]);
+
+        evaluate_tree(&bench -> tree, &bench -> var_table, &expected[j]);
+    }
+    double tree_time = get_time_seconds() - start;
+
+    start = get_time_seconds();
+    tree_error_type error = evaluate_batch(&expr, bench -> variables, bench -> points, results);
+    double batch_time = get_time_seconds() - start;
+
+    point_error_mask* errors = (point_error_mask*)calloc(bench -> points, sizeof(point_error_mask));
+    double ieee_time = 0.0;
+    size_t failed_points = 0;
+    if (errors != NULL)
+    {
+        start = get_time_seconds();
+        evaluate_batch_ieee(&expr, bench -> variables, bench -> points, results, errors);
+        ieee_time = get_time_seconds() - start;
+
+        for (size_t j = 0; j < bench -> points; j++)
+            failed_points += (errors[j] != 0);
+    }
+
+    printf("%s\n", expression);
+    printf("  max |batch - tree|: %g\n", max_difference(expected, results, bench -> points));
+    printf("  evaluate_tree : %8.3f Mpoints/s\n", (double)bench -> points / tree_time  * 1e-6);
+    printf("  evaluate_batch: %8.3f Mpoints/s (%s kernels, %s)\n", (double)bench -> points / batch_time * 1e-6,
+           batch_kernels_name(), (error == TREE_ERROR_NO) ? "ok" : "error");
+    printf("  evaluate_ieee : %8.3f Mpoints/s (%zu points with domain errors)\n",
+           (double)bench -> points / ieee_time * 1e-6, failed_points);
+
+    free(errors);
+    free(expected);
+    free(results);
+    compiled_expression_destructor(&expr);
+}
+
+
+static void benchmark_jit_evaluation(benchmark_case* bench, const char* expression)
+{
+    jit_expression jit = {};
+    jit_constructor(&jit);
+
+    double start = get_time_seconds();
+    tree_error_type error = jit_compile(&bench -> tree, &bench -> var_table, &jit);
+    double compile_time = get_time_seconds() - start;
+
+    double* results = (double*)calloc(bench -> points, sizeof(double));
+    if (error != TREE_ERROR_NO || results == NULL)
+    {
+        printf("  failed to compile expression\n");
+        free(results);
+        jit_destructor(&jit);
+        return;
+    }
+
+    start = get_time_seconds();
+    error = jit_evaluate_batch(&jit, bench -> variables, bench -> points, results);
+    double batch_time = get_time_seconds() - start;
+
+    printf("%s\n", expression);
+    printf("  compile       : %8.3f ms (%s)\n", compile_time * 1e3, jit_is_native(&jit) ? "native" : "interpreter");
+    printf("  jit batch     : %8.3f Mpoints/s (%s)\n", (double)bench -> points / batch_time * 1e-6,
+           (error == TREE_ERROR_NO) ? "ok" : "error");
+
+    free(results);
+    jit_destructor(&jit);
+}
+
+
+static void benchmark_parallel_evaluation(benchmark_case* bench, const char* expression)
+{
+    compiled_expression expr = {};
+    compiled_expression_constructor(&expr);
+
+    double* results = (double*)calloc(bench -> points, sizeof(double));
+    if (results == NULL || compile_tree(&bench -> tree, &bench -> var_table, &expr) != TREE_ERROR_NO)
+    {
+        printf("  failed to compile expression\n");
+        free(results);
+        compiled_expression_destructor(&expr);
+        return;
+    }
+
+    printf("%s\n", expression);
+
+    size_t max_threads = std::thread::hardware_concurrency();
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        thread_pool* pool = NULL;
+        if (thread_pool_create(threads, &pool) != TREE_ERROR_NO)
+            break;
+
+        double start = get_time_seconds();
+        tree_error_type error = evaluate_batch_parallel(pool, &expr, bench -> variables, bench -> points, results);
+        double parallel_time = get_time_seconds() - start;
+
+        printf("  %3zu threads   : %8.3f Mpoints/s (%s)\n", threads,
+               (double)bench -> points / parallel_time * 1e-6, (error == TREE_ERROR_NO) ? "ok" : "error");
+
+        thread_pool_destroy(pool);
+    }
+
+    free(results);
+    compiled_expression_destructor(&expr);
+}
+
+
+static void benchmark_sweep_evaluation(benchmark_case* bench, const char* expression)
+{
+    compiled_expression expr = {};
+    sweep_expression sweep = {};
+    compiled_expression_constructor(&expr);
+    sweep_expression_constructor(&sweep);
+
+    // все переменные, кроме x, фиксированы
+    for (int i = 0; i < bench -> var_table.number_of_variables; i++)
+    {
+        set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, bench -> variables[i][0]);
+        for (size_t j = 1; i > 0 && j < bench -> points; j++)
+            bench -> variables[i][j] = bench -> variables[i][0];
+    }
+
+    double* expected = (double*)calloc(bench -> points, sizeof(double));
+    double* results  = (double*)calloc(bench -> points, sizeof(double));
+    if (expected == NULL || results == NULL ||
+        compile_tree(&bench -> tree, &bench -> var_table, &expr) != TREE_ERROR_NO)
+    {
+        printf("  failed to compile expression\n");
+        free(expected);
+        free(results);
+        compiled_expression_destructor(&expr);
+        return;
+    }
+
+    double start = get_time_seconds();
+    evaluate_batch(&expr, bench -> variables, bench -> points, expected);
+    double batch_time = get_time_seconds() - start;
+
+    start = get_time_seconds();
+    tree_error_type error = prepare_sweep(&expr, &bench -> var_table, bench -> var_table.variables[0].name, &sweep);
+    if (error == TREE_ERROR_NO)
+        error = evaluate_sweep(&sweep, bench -> variables[0], bench -> points, results);
+    double sweep_time = get_time_seconds() - start;
+
+    printf("%s\n", expression);
+    printf("  max |sweep - batch|: %g, hoisted %zu of %zu instructions\n",
+           max_difference(expected, results, bench -> points), sweep.hoisted_instructions, expr.size);
+    printf("  evaluate_batch: %8.3f Mpoints/s\n", (double)bench -> points / batch_time * 1e-6);
+    printf("  evaluate_sweep: %8.3f Mpoints/s (%s)\n", (double)bench -> points / sweep_time * 1e-6,
+           (error == TREE_ERROR_NO) ? "ok" : "error");
+
+    free(expected);
+    free(results);
+    sweep_expression_destructor(&sweep);
+    compiled_expression_destructor(&expr);
+}
+
+
+// Каждая переменная по очереди меняется DERIVATIVE_QUERIES раз, остальные фиксированы;
+// после каждого set_variable_value incremental_evaluate сверяется с полным evaluate_compiled
+static void benchmark_incremental_evaluation(benchmark_case* bench, const char* expression)
+{
+    compiled_expression   expr      = {};
+    incremental_evaluator evaluator = {};
+    compiled_expression_constructor(&expr);
+
+    int number_of_variables = bench -> var_table.number_of_variables;
+    for (int i = 0; i < number_of_variables; i++)
+        set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, bench -> variables[i][0]);
+
+    double  values[MAX_NUMBER_OF_VARIABLES] = {};
+    double* expected = (double*)calloc(DERIVATIVE_QUERIES, sizeof(double));
+    double* results  = (double*)calloc(DERIVATIVE_QUERIES, sizeof(double));
+    double* slots    = NULL;
+
+    tree_error_type error = compile_tree(&bench -> tree, &bench -> var_table, &expr);
+    if (error == TREE_ERROR_NO)
+        error = incremental_evaluator_create(&evaluator, &expr);
+    if (error == TREE_ERROR_NO)
+        slots = (double*)calloc(expr.size + 1, sizeof(double));
+
+    if (expected == NULL || results == NULL || slots == NULL)
+    {
+        printf("  failed to compile expression\n");
+        free(expected);
+        free(results);
+        free(slots);
+        incremental_evaluator_destroy(&evaluator);
+        compiled_expression_destructor(&expr);
+        return;
+    }
+
+    printf("%s\n", expression);
+
+    for (int variable = 0; error == TREE_ERROR_NO && variable < number_of_variables; variable++)
+    {
+        const char* name = bench -> var_table.variables[variable].name;
+
+        // первый вызов считает всё дерево и заполняет кэш
+        double result = 0.0;
+        error = incremental_evaluate(&evaluator, &bench -> var_table, &result);
+
+        size_t executed = 0;
+        double start = get_time_seconds();
+        for (size_t j = 0; error == TREE_ERROR_NO && j < DERIVATIVE_QUERIES; j++)
+        {
+            set_variable_value(&bench -> var_table, name, bench -> variables[variable][j]);
+            error = incremental_evaluate(&evaluator, &bench -> var_table, &results[j]);
+            executed += evaluator.executed;
+        }
+        double incremental_time = get_time_seconds() - start;
+
+        start = get_time_seconds();
+        for (size_t j = 0; error == TREE_ERROR_NO && j < DERIVATIVE_QUERIES; j++)
+        {
+            set_variable_value(&bench -> var_table, name, bench -> variables[variable][j]);
+            for (int i = 0; i < number_of_variables; i++)
+                values[i] = bench -> var_table.variables[i].value;
+
+            error = evaluate_compiled(&expr, values, slots, &expected[j]);
+        }
+        double compiled_time = get_time_seconds() - start;
+
+        printf("  %s: re-executed %.1f of %zu instructions per update, max |incremental - compiled|: %g\n",
+               name, (double)executed / (double)DERIVATIVE_QUERIES, expr.size,
+               max_difference(expected, results, DERIVATIVE_QUERIES));
+        printf("    evaluate_compiled   : %8.3f us per update\n", compiled_time / (double)DERIVATIVE_QUERIES * 1e6);
+        printf("    incremental_evaluate: %8.3f us per update (%s)\n", incremental_time / (double)DERIVATIVE_QUERIES * 1e6,
+               (error == TREE_ERROR_NO) ? "ok" : "error");
+    }
+
+    free(expected);
+    free(results);
+    free(slots);
+    incremental_evaluator_destroy(&evaluator);
+    compiled_expression_destructor(&expr);
+}
+
+
+static void benchmark_power_reduction(benchmark_case* bench, const char* expression)
+{
+    compiled_expression reduced = {};
+    compiled_expression_constructor(&reduced);
+
+    double* expected = (double*)calloc(bench -> points, sizeof(double));
+    double* results  = (double*)calloc(bench -> points, sizeof(double));
+    if (expected == NULL || results == NULL ||
+        compile_tree(&bench -> tree, &bench -> var_table, &reduced) != TREE_ERROR_NO)
+    {
+        printf("  failed to compile expression\n");
+        free(expected);
+        free(results);
+        compiled_expression_destructor(&reduced);
+        return;
+    }
+
+    // та же программа, но с pow(): перед каждой INSTR_POWI вставляется константа-показатель
+    compiled_expression generic = reduced;
+    generic.instructions = (instruction_t*)calloc(2 * reduced.size + 1, sizeof(instruction_t));
+    int* remap = (int*)calloc(reduced.size + 1, sizeof(int));
+    if (generic.instructions == NULL || remap == NULL)
+    {
+        free(generic.instructions);
+        free(remap);
+        free(expected);
+        free(results);
+        compiled_expression_destructor(&reduced);
+        return;
+    }
+
+    size_t reduced_powers = 0;
+    generic.size = 0;
+
+    for (size_t i = 0; i < reduced.size; i++)
+    {
+        instruction_t instruction = reduced.instructions[i];
+        if (instruction.left  != NO_OPERAND) instruction.left  = remap[instruction.left];
+        if (instruction.right != NO_OPERAND) instruction.right = remap[instruction.right];
+
+        if (instruction.code == INSTR_POWI)
+        {
+            instruction_t exponent = {INSTR_NUM, NO_OPERAND, NO_OPERAND, NO_OPERAND, instruction.value};
+            generic.instructions[generic.size] = exponent;
+
+            instruction.code  = INSTR_POW;
+            instruction.right = (int)generic.size++;
+            reduced_powers++;
+        }
+
+        generic.instructions[generic.size] = instruction;
+        remap[i] = (int)generic.size++;
+    }
+
+    generic.capacity = 2 * reduced.size + 1;
+    generic.result   = remap[reduced.result];
+    free(remap);
+
+    double start = get_time_seconds();
+    evaluate_batch(&generic, bench -> variables, bench -> points, expected);
+    double pow_time = get_time_seconds() - start;
+
+    start = get_time_seconds();
+    tree_error_type error = evaluate_batch(&reduced, bench -> variables, bench -> points, results);
+    double reduced_time = get_time_seconds() - start;
+
+    double max_relative = 0.0;
+    for (size_t j = 0; j < bench -> points; j++)
+        if (fabs(expected[j]) > 0 && fabs(results[j] - expected[j]) / fabs(expected[j]) > max_relative)
+            max_relative = fabs(results[j] - expected[j]) / fabs(expected[j]);
+
+    printf("%s\n", expression);
+    printf("  reduced %zu of the powers, max relative difference: %g\n", reduced_powers, max_relative);
+    printf("  pow()         : %8.3f Mpoints/s\n", (double)bench -> points / pow_time * 1e-6);
+    printf("  reduced       : %8.3f Mpoints/s (%s)\n", (double)bench -> points / reduced_time * 1e-6,
+           (error == TREE_ERROR_NO) ? "ok" : "error");
+
+    free(generic.instructions);
+    free(expected);
+    free(results);
+    compiled_expression_destructor(&reduced);
+}
+
+
+static void benchmark_typed_evaluation(benchmark_case* bench, const char* expression)
+{
+    compiled_expression expr = {};
+    compiled_expression_constructor(&expr);
+
+    int number_of_variables = bench -> var_table.number_of_variables;
+
+    float**       float_variables = (float**)      calloc((size_t)number_of_variables + 1, sizeof(float*));
+    long double** long_variables  = (long double**)calloc((size_t)number_of_variables + 1, sizeof(long double*));
+    float*        float_results   = (float*)       calloc(bench -> points, sizeof(float));
+    double*       double_results  = (double*)      calloc(bench -> points, sizeof(double));
+    long double*  long_results    = (long double*) calloc(bench -> points, sizeof(long double));
+
+    bool is_ready = (float_variables != NULL && long_variables != NULL && float_results != NULL &&
+                     double_results != NULL && long_results != NULL &&
+                     compile_tree(&bench -> tree, &bench -> var_table, &expr) == TREE_ERROR_NO);
+
+    for (int i = 0; is_ready && i < number_of_variables; i++)
+    {
+        float_variables[i] = (float*)      calloc(bench -> points, sizeof(float));
+        long_variables[i]  = (long double*)calloc(bench -> points, sizeof(long double));
+        is_ready = (float_variables[i] != NULL && long_variables[i] != NULL);
+
+        for (size_t j = 0; is_ready && j < bench -> points; j++)
+        {
+            float_variables[i][j] = (float)bench -> variables[i][j];
+            long_variables[i][j]  = bench -> variables[i][j];
+        }
+    }
+
+    if (is_ready)
+    {
+        double start = get_time_seconds();
+        evaluate_batch_as(&expr, float_variables, bench -> points, float_results);
+        double float_time = get_time_seconds() - start;
+
+        start = get_time_seconds();
+        evaluate_batch_as(&expr, bench -> variables, bench -> points, double_results);
+        double double_time = get_time_seconds() - start;
+
+        start = get_time_seconds();
+        evaluate_batch_as(&expr, long_variables, bench -> points, long_results);
+        double long_time = get_time_seconds() - start;
+
+        double float_error = 0.0, double_error = 0.0;
+        for (size_t j = 0; j < bench -> points; j++)
+        {
+            double scale = (double)fabsl(long_results[j]) + 1.0;
+            double float_diff  = (double)fabsl(long_results[j] - float_results[j])  / scale;
+            double double_diff = (double)fabsl(long_results[j] - double_results[j]) / scale;
+
+            if (float_diff  > float_error)  float_error  = float_diff;
+            if (double_diff > double_error) double_error = double_diff;
+        }
+
+        printf("%s\n", expression);
+        printf("  float         : %8.3f Mpoints/s (max error vs long double %g)\n",
+               (double)bench -> points / float_time * 1e-6, float_error);
+        printf("  double        : %8.3f Mpoints/s (max error vs long double %g)\n",
+               (double)bench -> points / double_time * 1e-6, double_error);
+        printf("  long double   : %8.3f Mpoints/s\n", (double)bench -> points / long_time * 1e-6);
+    }
+    else
+    {
+        printf("  failed to prepare expression\n");
+    }
+
+    for (int i = 0; i < number_of_variables; i++)
+    {
+        free(float_variables != NULL ? float_variables[i] : NULL);
+        free(long_variables  != NULL ? long_variables[i]  : NULL);
+    }
+    free(float_variables);
+    free(long_variables);
+    free(float_results);
+    free(double_results);
+    free(long_results);
+    compiled_expression_destructor(&expr);
+}
+
+
+static void benchmark_fast_math(benchmark_case* bench, const char* expression)
+{
+    compiled_expression expr = {};
+    compiled_expression_constructor(&expr);
+
+    double* expected = (double*)calloc(bench -> points, sizeof(double));
+    double* results  = (double*)calloc(bench -> points, sizeof(double));
+    if (expected == NULL || results == NULL ||
+        compile_tree(&bench -> tree, &bench -> var_table, &expr) != TREE_ERROR_NO)
+    {
+        printf("  failed to compile expression\n");
+        free(expected);
+        free(results);
+        compiled_expression_destructor(&expr);
+        return;
+    }
+
+    batch_set_math_mode(BATCH_MATH_EXACT);
+    double start = get_time_seconds();
+    evaluate_batch(&expr, bench -> variables, bench -> points, expected);
+    double exact_time = get_time_seconds() - start;
+
+    batch_set_math_mode(BATCH_MATH_FAST);
+    start = get_time_seconds();
+    tree_error_type error = evaluate_batch(&expr, bench -> variables, bench -> points, results);
+    double fast_time = get_time_seconds() - start;
+    batch_set_math_mode(BATCH_MATH_EXACT);
+
+    double max_ulp = 0.0;
+    for (size_t j = 0; j < bench -> points; j++)
+        if (ulp_distance(expected[j], results[j]) > max_ulp)
+            max_ulp = ulp_distance(expected[j], results[j]);
+
+    printf("%s\n", expression);
+    printf("  max |fast - libm|: %g (%g ulp of the result)\n",
+           max_difference(expected, results, bench -> points), max_ulp);
+    printf("  libm          : %8.3f Mpoints/s\n", (double)bench -> points / exact_time * 1e-6);
+    printf("  fast math     : %8.3f Mpoints/s (%s kernels, %s)\n", (double)bench -> points / fast_time * 1e-6,
+           fast_math_kernels_name(), (error == TREE_ERROR_NO) ? "ok" : "error");
+
+    free(expected);
+    free(results);
+    compiled_expression_destructor(&expr);
+}
+
+
+// splitmix64: равномерная сетка обнуляет младшие биты мантиссы и прячет худшие случаи
+static double random_argument(uint64_t* state, double low, double high)
+{
+    uint64_t bits = (*state += 0x9e3779b97f4a7c15ull);
+    bits = (bits ^ (bits >> 30)) * 0xbf58476d1ce4e5b9ull;
+    bits = (bits ^ (bits >> 27)) * 0x94d049bb133111ebull;
+    bits =  bits ^ (bits >> 31);
+
+    return low + (high - low) * ((double)(bits >> 11) * 0x1p-53);
+}
+
+
+static void benchmark_fast_math_function(const char* name, double (*reference)(double),
+                                         void (*fast_block)(const double*, double*, size_t),
+                                         double low, double high, double ulp_bound)
+{
+    double* arguments = (double*)calloc(BENCHMARK_POINTS, sizeof(double));
+    double* expected  = (double*)calloc(BENCHMARK_POINTS, sizeof(double));
+    double* results   = (double*)calloc(BENCHMARK_POINTS, sizeof(double));
+    if (arguments == NULL || expected == NULL || results == NULL)
+    {
+        free(arguments);
+        free(expected);
+        free(results);
+        return;
+    }
+
+    uint64_t state = 1;
+    for (size_t j = 0; j < BENCHMARK_POINTS; j++)
+        arguments[j] = random_argument(&state, low, high);
+
+    double start = get_time_seconds();
+    for (size_t j = 0; j < BENCHMARK_POINTS; j++)
+        expected[j] = reference(arguments[j]);
+    double libm_time = get_time_seconds() - start;
+
+    start = get_time_seconds();
+    for (size_t j = 0; j < BENCHMARK_POINTS; j += BATCH_BLOCK_SIZE)
+        fast_block(arguments + j, results + j,
+                   (BENCHMARK_POINTS - j < BATCH_BLOCK_SIZE) ? BENCHMARK_POINTS - j : BATCH_BLOCK_SIZE);
+    double fast_time = get_time_seconds() - start;
+
+    double max_ulp = 0.0;
+    for (size_t j = 0; j < BENCHMARK_POINTS; j++)
+        if (ulp_distance(expected[j], results[j]) > max_ulp)
+            max_ulp = ulp_distance(expected[j], results[j]);
+
+    printf("  %-4s on [%g, %g]: %5.2fx faster than libm, max error %g ulp (bound %g)\n",
+           name, low, high, libm_time / fast_time, max_ulp, ulp_bound);
+    assert(max_ulp <= ulp_bound);
+
+    free(arguments);
+    free(expected);
+    free(results);
+}
+
+
+// Все частные производные одного обратного прохода сверяются с дуальными числами
+// по каждой переменной; время градиента сравнивается с n вызовами differentiate_tree
+static void benchmark_reverse_mode(benchmark_case* bench, const char* expression)
+{
+    int n = bench -> var_table.number_of_variables;
+    for (int i = 0; i < n; i++)
+        set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, bench -> variables[i][0]);
+
+    double values  [MAX_NUMBER_OF_VARIABLES] = {};
+    double gradient[MAX_NUMBER_OF_VARIABLES] = {};
+    double computed[MAX_NUMBER_OF_VARIABLES] = {};
+    double value = 0.0, computed_value = 0.0;
+
+    gradient_tape tape = {};
+    gradient_tape_constructor(&tape);
+
+    tree_error_type error = record_gradient_tape(&bench -> tree, &bench -> var_table, &tape);
+    if (error == TREE_ERROR_NO)
+        error = compute_gradient(&bench -> tree, &bench -> var_table, &computed_value, computed);
+
+    double max_error = 0.0;
+
+    for (size_t j = 0; error == TREE_ERROR_NO && j < DERIVATIVE_QUERIES; j++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            values[i] = bench -> variables[i][j];
+            set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, values[i]);
+        }
+
+        error = evaluate_gradient(&tape, values, &value, gradient);
+
+        // compute_gradient посчитан в первой точке: запись ленты и один проход должны совпасть с ней
+        for (int i = 0; error == TREE_ERROR_NO && j == 0 && i < n; i++)
+            max_error = fmax(max_error, fabs(gradient[i] - computed[i]) + fabs(value - computed_value));
+
+        for (int i = 0; error == TREE_ERROR_NO && i < n; i++)
+        {
+            double dual_value = 0.0, derivative = 0.0;
+            error = evaluate_tree_with_derivative(&bench -> tree, &bench -> var_table, bench -> var_table.variables[i].name,
+                                                  &dual_value, &derivative);
+
+            double relative = fabs(gradient[i] - derivative) / fmax(1.0, fabs(derivative));
+            if (relative > max_error)
+                max_error = relative;
+        }
+    }
+
+    double symbolic_sum = 0.0;
+    double start = get_time_seconds();
+    for (size_t j = 0; error == TREE_ERROR_NO && j < DERIVATIVE_QUERIES; j++)
+    {
+        for (int i = 0; i < n; i++)
+            set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, bench -> variables[i][j]);
+
+        for (int i = 0; error == TREE_ERROR_NO && i < n; i++)
+        {
+            tree_t derivative = {};
+            tree_constructor(&derivative);
+
+            double partial = 0.0;
+            error = differentiate_tree(&bench -> tree, bench -> var_table.variables[i].name, &derivative);
+            if (error == TREE_ERROR_NO)
+                error = evaluate_tree(&derivative, &bench -> var_table, &partial);
+            symbolic_sum += partial;
+
+            tree_destructor(&derivative);
+        }
+    }
+    double symbolic_time = get_time_seconds() - start;
+
+    double reverse_sum = 0.0;
+    start = get_time_seconds();
+    for (size_t j = 0; error == TREE_ERROR_NO && j < DERIVATIVE_QUERIES; j++)
+    {
+        for (int i = 0; i < n; i++)
+            values[i] = bench -> variables[i][j];
+
+        error = evaluate_gradient(&tape, values, &value, gradient);
+        for (int i = 0; i < n; i++)
+            reverse_sum += gradient[i];
+    }
+    double reverse_time = get_time_seconds() - start;
+
+    const char* status = (error != TREE_ERROR_NO) ? "error" : (max_error <= GRADIENT_TOLERANCE) ? "ok" : "mismatch";
+
+    printf("%s\n", expression);
+    printf("  max relative |reverse - dual| over %d partials at %zu points: %g\n", n, DERIVATIVE_QUERIES, max_error);
+    printf("  |sum of symbolic - sum of reverse|: %g\n", fabs(symbolic_sum - reverse_sum));
+    printf("  %d x differentiate_tree + evaluate_tree: %8.3f us per gradient\n", n,
+           symbolic_time / (double)DERIVATIVE_QUERIES * 1e6);
+    printf("  one backward sweep                   : %8.3f us per gradient (%s)\n",
+           reverse_time / (double)DERIVATIVE_QUERIES * 1e6, status);
+
+    gradient_tape_destructor(&tape);
+}
+
+
+static void benchmark_forward_mode(benchmark_case* bench, const char* expression)
+{
+    const char* variable_name = bench -> var_table.variables[0].name;
+
+    for (int i = 0; i < bench -> var_table.number_of_variables; i++)
+        set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, bench -> variables[i][0]);
+
+    double symbolic_sum = 0.0, dual_sum = 0.0;
+    tree_error_type error = TREE_ERROR_NO;
+
+    double start = get_time_seconds();
+    for (size_t j = 0; error == TREE_ERROR_NO && j < DERIVATIVE_QUERIES; j++)
+    {
+        set_variable_value(&bench -> var_table, variable_name, bench -> variables[0][j]);
+
+        tree_t derivative = {};
+        tree_constructor(&derivative);
+
+        double value = 0.0;
+        error = differentiate_tree(&bench -> tree, variable_name, &derivative);
+        if (error == TREE_ERROR_NO)
+            error = evaluate_tree(&derivative, &bench -> var_table, &value);
+        symbolic_sum += value;
+
+        tree_destructor(&derivative);
+    }
+    double symbolic_time = get_time_seconds() - start;
+
+    start = get_time_seconds();
+    for (size_t j = 0; error == TREE_ERROR_NO && j < DERIVATIVE_QUERIES; j++)
+    {
+        set_variable_value(&bench -> var_table, variable_name, bench -> variables[0][j]);
+
+        double value = 0.0, derivative = 0.0;
+        error = evaluate_tree_with_derivative(&bench -> tree, &bench -> var_table, variable_name, &value, &derivative);
+        dual_sum += derivative;
+    }
+    double dual_time = get_time_seconds() - start;
+
+    printf("%s\n", expression);
+    printf("  |sum of symbolic - sum of dual| over %zu points: %g\n", DERIVATIVE_QUERIES, fabs(symbolic_sum - dual_sum));
+    printf("  differentiate_tree + evaluate_tree: %8.3f us per derivative\n", symbolic_time / (double)DERIVATIVE_QUERIES * 1e6);
+    printf("  dual numbers                      : %8.3f us per derivative (%s)\n", dual_time / (double)DERIVATIVE_QUERIES * 1e6,
+           (error == TREE_ERROR_NO) ? "ok" : "error");
+}
+
+
+static void benchmark_taylor_mode(benchmark_case* bench, const char* expression)
+{
+    char variable_name[MAX_VARIABLE_LENGTH] = "";
+    snprintf(variable_name, sizeof(variable_name), "%s", bench -> var_table.variables[0].name);
+
+    for (int i = 0; i < bench -> var_table.number_of_variables; i++)
+        set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, bench -> variables[i][0]);
+
+    // символьная цепочка: каждый порядок дифференцирует предыдущее дерево
+    tree_t derivatives[SYMBOLIC_ORDER + 1] = {};
+    derivatives[0] = bench -> tree;
+
+    double symbolic[SYMBOLIC_ORDER + 1] = {};
+    size_t symbolic_nodes = 0;
+    tree_error_type error = TREE_ERROR_NO;
+
+    double start = get_time_seconds();
+    for (size_t k = 1; error == TREE_ERROR_NO && k <= SYMBOLIC_ORDER; k++)
+    {
+        tree_constructor(&derivatives[k]);
+        error = differentiate_tree(&derivatives[k - 1], variable_name, &derivatives[k]);
+        if (error == TREE_ERROR_NO)
+            error = evaluate_tree(&derivatives[k], &bench -> var_table, &symbolic[k]);
+        if (error == TREE_ERROR_NO)
+            symbolic_nodes = count_tree_nodes(derivatives[k].root);
+    }
+    double symbolic_time = get_time_seconds() - start;
+
+    for (size_t k = 1; k <= SYMBOLIC_ORDER; k++)
+        tree_destructor(&derivatives[k]);
+
+    double taylor[TAYLOR_ORDER + 1] = {};
+
+    // прогрев: первый вызов платит за выделение памяти и холодный кэш
+    if (error == TREE_ERROR_NO)
+        error = evaluate_taylor_tree(&bench -> tree, &bench -> var_table, variable_name, TAYLOR_ORDER, taylor);
+
+    start = get_time_seconds();
+    if (error == TREE_ERROR_NO)
+        error = evaluate_taylor_tree(&bench -> tree, &bench -> var_table, variable_name, SYMBOLIC_ORDER, taylor);
+    double taylor_time = get_time_seconds() - start;
+
+    double max_relative = 0.0;
+    for (size_t k = 1; k <= SYMBOLIC_ORDER; k++)
+        if (fabs(symbolic[k] - taylor[k]) / (fabs(symbolic[k]) + 1.0) > max_relative)
+            max_relative = fabs(symbolic[k] - taylor[k]) / (fabs(symbolic[k]) + 1.0);
+
+    start = get_time_seconds();
+    if (error == TREE_ERROR_NO)
+        error = evaluate_taylor_tree(&bench -> tree, &bench -> var_table, variable_name, TAYLOR_ORDER, taylor);
+    double high_order_time = get_time_seconds() - start;
+
+    printf("%s\n", expression);
+    printf("  max relative |symbolic - taylor| up to order %zu: %g\n", SYMBOLIC_ORDER, max_relative);
+    printf("  symbolic chain, order %2zu: %10.3f us, %zu nodes in the last tree\n",
+           SYMBOLIC_ORDER, symbolic_time * 1e6, symbolic_nodes);
+    printf("  taylor series,  order %2zu: %10.3f us (%s)\n", SYMBOLIC_ORDER, taylor_time * 1e6,
+           (error == TREE_ERROR_NO) ? "ok" : "error");
+    printf("  taylor series,  order %2zu: %10.3f us\n", TAYLOR_ORDER, high_order_time * 1e6);
+}
+
+
+static void benchmark_symbolic_gradient(benchmark_case* bench, const char* expression)
+{
+    int n = bench -> var_table.number_of_variables;
+
+    char names[MAX_NUMBER_OF_VARIABLES][MAX_VARIABLE_LENGTH] = {};
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "%s", bench -> var_table.variables[i].name);
+        set_variable_value(&bench -> var_table, names[i], bench -> variables[i][0]);
+    }
+
+    // отдельное дерево на каждую производную первого и второго порядка
+    tree_error_type error = TREE_ERROR_NO;
+    size_t separate_nodes = 0;
+    double separate_sum = 0.0;
+
+    double start = get_time_seconds();
+    for (int i = 0; error == TREE_ERROR_NO && i < n; i++)
+    {
+        tree_t gradient = {};
+        tree_constructor(&gradient);
+        error = differentiate_tree(&bench -> tree, names[i], &gradient);
+        separate_nodes += (error == TREE_ERROR_NO) ? gradient.size : 0;
+
+        for (int j = 0; error == TREE_ERROR_NO && j < n; j++)
+        {
+            tree_t second = {};
+            tree_constructor(&second);
+            double value = 0.0;
+            error = differentiate_tree(&gradient, names[j], &second);
+            if (error == TREE_ERROR_NO)
+            {
+                separate_nodes += second.size;
+                error = evaluate_tree(&second, &bench -> var_table, &value);
+            }
+            separate_sum += value;
+            tree_destructor(&second);
+        }
+
+        tree_destructor(&gradient);
+    }
+    double separate_time = get_time_seconds() - start;
+
+    symbolic_derivatives derivatives = {};
+    symbolic_derivatives_constructor(&derivatives);
+    double shared_sum = 0.0;
+
+    start = get_time_seconds();
+    if (error == TREE_ERROR_NO)
+        error = differentiate_tree_all(&bench -> tree, &bench -> var_table, true, &derivatives);
+    for (int i = 0; error == TREE_ERROR_NO && i < n * n; i++)
+    {
+        tree_t entry = {derivatives.hessians[i], 0, NULL};
+        double value = 0.0;
+        error = evaluate_tree(&entry, &bench -> var_table, &value);
+        shared_sum += value;
+    }
+    double shared_time = get_time_seconds() - start;
+
+    printf("%s\n", expression);
+    printf("  |sum of hessian entries, separate - shared|: %g\n", fabs(separate_sum - shared_sum));
+    printf("  separate trees  : %8zu nodes, %10.3f us\n", separate_nodes, separate_time * 1e6);
+    printf("  shared DAG      : %8zu nodes, %10.3f us (%s)\n", derivatives.size, shared_time * 1e6,
+           (error == TREE_ERROR_NO) ? "ok" : "error");
+
+    symbolic_derivatives_destructor(&derivatives);
+}
+
+
+// Цепочка производных до SYMBOLIC_ORDER; возвращает последнее дерево
+static tree_error_type differentiate_chain(tree_t* tree, const char* variable_name, tree_t* last)
+{
+    tree_t derivatives[SYMBOLIC_ORDER + 1] = {};
+    derivatives[0] = *tree;
+
+    tree_error_type error = TREE_ERROR_NO;
+    size_t order = 0;
+
+    for (size_t k = 1; error == TREE_ERROR_NO && k <= SYMBOLIC_ORDER; k++)
+    {
+        tree_constructor(&derivatives[k]);
+        error = differentiate_tree(&derivatives[k - 1], variable_name, &derivatives[k]);
+        order = k;
+    }
+
+    for (size_t k = 1; k < order; k++)
+        tree_destructor(&derivatives[k]);
+
+    *last = derivatives[order];
+    return error;
+}
+
+
+// Сумма WIDE_SUM_TERMS слагаемых sin(x*k+y) и cos(x*k+y), часть из них вычитается
+static char* create_wide_sum_expression(size_t number_of_terms)
+{
+    size_t length     = 0;
+    size_t max_length = number_of_terms * 32 + 2;
+
+    char* expression = (char*)calloc(max_length, sizeof(char));
+    if (expression == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < number_of_terms; i++)
+        length += (size_t)snprintf(expression + length, max_length - length, "%s%s(x*%zu+y)",
+                                   (i == 0) ? "" : ((i % 3 == 1) ? "-" : "+"),
+                                   (i % 2 == 0) ? "sin" : "cos", i % 7 + 1);
+
+    snprintf(expression + length, max_length - length, "$");
+
+    return expression;
+}
+
+
+static void benchmark_parallel_differentiation(size_t number_of_terms)
+{
+    char* expression = create_wide_sum_expression(number_of_terms);
+    benchmark_case bench = {};
+
+    if (expression == NULL || create_benchmark_case(&bench, expression, 1) != TREE_ERROR_NO)
+    {
+        printf("  failed to build wide sum\n");
+        destroy_benchmark_case(&bench);
+        free(expression);
+        return;
+    }
+
+    char names[2][MAX_VARIABLE_LENGTH] = {};
+    for (int i = 0; i < bench.var_table.number_of_variables && i < 2; i++)
+        snprintf(names[i], sizeof(names[i]), "%s", bench.var_table.variables[i].name);
+    for (int i = 0; i < bench.var_table.number_of_variables && i < 2; i++)
+        set_variable_value(&bench.var_table, names[i], 0.5);
+
+    tree_t sequential = {};
+    double start = get_time_seconds();
+    tree_error_type error = differentiate_tree(&bench.tree, "x", &sequential);
+    double sequential_time = get_time_seconds() - start;
+
+    double expected = 0.0;
+    if (error == TREE_ERROR_NO)
+        evaluate_tree(&sequential, &bench.var_table, &expected);
+
+    printf("sum of %zu terms, %zu nodes\n", number_of_terms, bench.tree.size);
+    printf("  sequential    : %10.3f ms, %zu nodes (%s)\n", sequential_time * 1e3,
+           count_tree_nodes(sequential.root), (error == TREE_ERROR_NO) ? "ok" : "error");
+
+    size_t max_threads = std::thread::hardware_concurrency();
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        thread_pool* pool = NULL;
+        if (thread_pool_create(threads, &pool) != TREE_ERROR_NO)
+            break;
+
+        tree_t parallel = {};
+        start = get_time_seconds();
+        error = differentiate_tree_parallel(pool, &bench.tree, "x", &parallel, NULL);
+        double parallel_time = get_time_seconds() - start;
+
+        double value = 0.0;
+        if (error == TREE_ERROR_NO)
+            evaluate_tree(&parallel, &bench.var_table, &value);
+
+        printf("  %3zu threads   : %10.3f ms, %zu nodes, difference %.3g (%s)\n", threads, parallel_time * 1e3,
+               count_tree_nodes(parallel.root), fabs(value - expected), (error == TREE_ERROR_NO) ? "ok" : "error");
+
+        tree_destructor(&parallel);
+        thread_pool_destroy(pool);
+    }
+
+    tree_destructor(&sequential);
+    destroy_benchmark_case(&bench);
+    free(expression);
+}
+
+
+// Цепочка производных до EGRAPH_ORDER с обычной оптимизацией, затем e-граф;
+// обе версии последней производной компилируются и считаются на всех точках
+static void benchmark_egraph_simplification(benchmark_case* bench, const char* expression)
+{
+    char variable_name[MAX_VARIABLE_LENGTH] = "";
+    snprintf(variable_name, sizeof(variable_name), "%s", bench -> var_table.variables[0].name);
+
+    // оптимизатор вычисляет дерево, значения нужны, чтобы он не запрашивал их
+    for (int i = 0; i < bench -> var_table.number_of_variables; i++)
+        set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, bench -> variables[i][0]);
+
+    tree_t derivative = {};
+    tree_error_type error = TREE_ERROR_NO;
+
+    for (size_t k = 1; error == TREE_ERROR_NO && k <= EGRAPH_ORDER; k++)
+    {
+        tree_t next = {};
+        tree_constructor(&next);
+        error = differentiate_tree((k == 1) ? &bench -> tree : &derivative, variable_name, &next);
+        if (k > 1)
+            tree_destructor(&derivative);
+        derivative = next;
+
+        if (error == TREE_ERROR_NO)
+            error = optimize_tree_with_dump(&derivative, NULL, &bench -> var_table);
+    }
+
+    compiled_expression greedy = {}, saturated = {};
+    compiled_expression_constructor(&greedy);
+    compiled_expression_constructor(&saturated);
+
+    size_t greedy_nodes = count_tree_nodes(derivative.root);
+    if (error == TREE_ERROR_NO)
+        error = compile_tree(&derivative, &bench -> var_table, &greedy);
+
+    egraph_stats stats = {};
+    double start = get_time_seconds();
+    if (error == TREE_ERROR_NO)
+        error = simplify_tree_with_egraph(&derivative, NULL, &stats);
+    double egraph_time = get_time_seconds() - start;
+
+    if (error == TREE_ERROR_NO)
+        error = compile_tree(&derivative, &bench -> var_table, &saturated);
+
+    double* expected = (double*)calloc(bench -> points, sizeof(double));
+    double* results  = (double*)calloc(bench -> points, sizeof(double));
+    if (error != TREE_ERROR_NO || expected == NULL || results == NULL)
+    {
+        printf("%s\n  failed to simplify derivative (%d)\n", expression, (int)error);
+        free(expected);
+        free(results);
+        compiled_expression_destructor(&greedy);
+        compiled_expression_destructor(&saturated);
+        tree_destructor(&derivative);
+        return;
+    }
+
+    start = get_time_seconds();
+    evaluate_batch(&greedy, bench -> variables, bench -> points, expected);
+    double greedy_time = get_time_seconds() - start;
+
+    start = get_time_seconds();
+    evaluate_batch(&saturated, bench -> variables, bench -> points, results);
+    double saturated_time = get_time_seconds() - start;
+
+    printf("%s\n", expression);
+    printf("  order %zu derivative, max |e-graph - greedy|: %g\n", EGRAPH_ORDER,
+           max_difference(expected, results, bench -> points));
+    printf("  greedy : %5zu nodes, %5zu instructions, cost %8.0f, %8.3f Mpoints/s\n", greedy_nodes,
+           greedy.size, stats.cost_before, (double)bench -> points / greedy_time * 1e-6);
+    printf("  e-graph: %5zu nodes, %5zu instructions, cost %8.0f, %8.3f Mpoints/s\n", count_tree_nodes(derivative.root),
+           saturated.size, stats.cost_after, (double)bench -> points / saturated_time * 1e-6);
+    printf("  saturation: %zu iterations, %zu e-nodes in %zu classes, %s, %.3f ms\n", stats.iterations,
+           stats.nodes, stats.classes, stats.saturated ? "saturated" : "stopped by limits", egraph_time * 1e3);
+
+    free(expected);
+    free(results);
+    compiled_expression_destructor(&greedy);
+    compiled_expression_destructor(&saturated);
+    tree_destructor(&derivative);
+}
+
+
+// Без общих подвыражений программа содержала бы по инструкции на узел дерева
+static void report_common_subexpressions(const char* label, tree_t* tree, benchmark_case* bench)
+{
+    compiled_expression expr = {};
+    compiled_expression_constructor(&expr);
+
+    size_t nodes = count_tree_nodes(tree -> root);
+    if (compile_tree(tree, &bench -> var_table, &expr) != TREE_ERROR_NO)
+    {
+        printf("  %s: compile error\n", label);
+        compiled_expression_destructor(&expr);
+        return;
+    }
+
+    double start = get_time_seconds();
+    double tree_value = 0.0;
+    evaluate_tree(tree, &bench -> var_table, &tree_value);
+    double tree_time = get_time_seconds() - start;
+
+    double* results = (double*)calloc(bench -> points, sizeof(double));
+    double batch_time = 0.0;
+    if (results != NULL)
+    {
+        start = get_time_seconds();
+        evaluate_batch(&expr, bench -> variables, bench -> points, results);
+        batch_time = get_time_seconds() - start;
+    }
+
+    printf("  %-9s: %6zu nodes -> %6zu instructions (%5.1f%% fewer ops), tree %8.3f us/point, dag %8.3f ns/point\n",
+           label, nodes, expr.size, 100.0 * (1.0 - (double)expr.size / (double)nodes), tree_time * 1e6,
+           (results != NULL) ? batch_time / (double)bench -> points * 1e9 : 0.0);
+
+    free(results);
+    compiled_expression_destructor(&expr);
+}
+
+
+static void benchmark_common_subexpressions(benchmark_case* bench, const char* expression)
+{
+    char variable_name[MAX_VARIABLE_LENGTH] = "";
+    snprintf(variable_name, sizeof(variable_name), "%s", bench -> var_table.variables[0].name);
+
+    for (int i = 0; i < bench -> var_table.number_of_variables; i++)
+        set_variable_value(&bench -> var_table, bench -> var_table.variables[i].name, bench -> variables[i][0]);
+
+    tree_t derivative = {};
+    tree_error_type error = differentiate_chain(&bench -> tree, variable_name, &derivative);
+
+    printf("%s\n", expression);
+    if (error == TREE_ERROR_NO)
+        report_common_subexpressions("raw", &derivative, bench);
+
+    if (error == TREE_ERROR_NO)
+        error = optimize_tree_with_dump(&derivative, NULL, &bench -> var_table);
+
+    if (error == TREE_ERROR_NO)
+        report_common_subexpressions("optimized", &derivative, bench);
+    else
+        printf("  order %zu derivative failed (%d)\n", SYMBOLIC_ORDER, (int)error);
+
+    tree_destructor(&derivative);
+}
+
+
+// Исходное дерево, схема Горнера и схема Эстрина для одного выражения
+static void benchmark_polynomial_form(const char* expression)
+{
+    const char* const names[] = {"tree", "horner", "estrin"};
+
+    benchmark_case bench = {};
+    double* expected = (double*)calloc(BENCHMARK_POINTS, sizeof(double));
+    double* results  = (double*)calloc(BENCHMARK_POINTS, sizeof(double));
+
+    if (create_benchmark_case(&bench, expression, BENCHMARK_POINTS) != TREE_ERROR_NO || expected == NULL || results == NULL)
+    {
+        printf("%s: setup error\n", expression);
+        free(expected);
+        free(results);
+        destroy_benchmark_case(&bench);
+        return;
+    }
+
+    printf("%s\n", expression);
+
+    for (int i = 0; i < 3; i++)
+    {
+        tree_t tree = {};
+        tree_constructor(&tree);
+
+        const char* ptr = expression;
+        tree.root = get_G(&ptr, &bench.var_table);
+
+        tree_error_type error = (tree.root == NULL) ? TREE_ERROR_FORMAT : TREE_ERROR_NO;
+        if (error == TREE_ERROR_NO && i > 0)
+            error = rewrite_polynomials(&tree, (i == 1) ? POLYNOMIAL_HORNER : POLYNOMIAL_ESTRIN);
+
+        compiled_expression expr = {};
+        compiled_expression_constructor(&expr);
+        if (error == TREE_ERROR_NO)
+            error = compile_tree(&tree, &bench.var_table, &expr);
+
+        if (error != TREE_ERROR_NO)
+        {
+            printf("  %-6s: failed (%d)\n", names[i], (int)error);
+            compiled_expression_destructor(&expr);
+            tree_destructor(&tree);
+            continue;
+        }
+
+        double* output = (i == 0) ? expected : results;
+
+        double start = get_time_seconds();
+        evaluate_batch(&expr, bench.variables, bench.points, output);
+        double batch_time = get_time_seconds() - start;
+
+        printf("  %-6s: %3zu nodes, %3zu instructions, cost %5.0f, %8.3f Mpoints/s, max |diff|: %g\n", names[i],
+               count_tree_nodes(tree.root), expr.size, evaluation_cost(tree.root),
+               (double)bench.points / batch_time * 1e-6, max_difference(expected, output, bench.points));
+
+        compiled_expression_destructor(&expr);
+        tree_destructor(&tree);
+    }
+
+    free(expected);
+    free(results);
+    destroy_benchmark_case(&bench);
+}
+
+
+static void run_benchmark(const char* title, void (*benchmark)(benchmark_case*, const char*))
+{
+    printf("==================== %s ====================\n", title);
+
+    for (size_t i = 0; i < NUMBER_OF_BENCHMARK_EXPRESSIONS; i++)
+    {
+        benchmark_case bench = {};
+        if (create_benchmark_case(&bench, BENCHMARK_EXPRESSIONS[i], BENCHMARK_POINTS) == TREE_ERROR_NO)
+            benchmark(&bench, BENCHMARK_EXPRESSIONS[i]);
+
+        destroy_benchmark_case(&bench);
+    }
+}
+
+
+int main()
+{
+    run_benchmark("batch evaluation", benchmark_batch_evaluation);
+    run_benchmark("jit evaluation",   benchmark_jit_evaluation);
+    run_benchmark("parallel batch evaluation", benchmark_parallel_evaluation);
+    run_benchmark("sweep evaluation", benchmark_sweep_evaluation);
+    run_benchmark("incremental evaluation", benchmark_incremental_evaluation);
+    run_benchmark("power strength reduction", benchmark_power_reduction);
+    run_benchmark("scalar type", benchmark_typed_evaluation);
+    run_benchmark("fast math", benchmark_fast_math);
+    run_benchmark("reverse mode gradient", benchmark_reverse_mode);
+    run_benchmark("forward mode derivative", benchmark_forward_mode);
+    run_benchmark("taylor mode derivatives", benchmark_taylor_mode);
+    run_benchmark("symbolic gradient and hessian", benchmark_symbolic_gradient);
+    run_benchmark("e-graph simplification", benchmark_egraph_simplification);
+    run_benchmark("common subexpressions", benchmark_common_subexpressions);
+
+    printf("==================== polynomial form ====================\n");
+    benchmark_polynomial_form("3*x^7-2*x^6+x^5+4*x^4-x^3+5*x^2-7*x+1$");
+    benchmark_polynomial_form("x^12-4*x^11+x^9+2*x^8-x^6+3*x^5-x^3+x^2-2*x+5$");
+    benchmark_polynomial_form("sin(x^3+2*x^2+x)+cos(x^5-4*x^3+x)*y$");
+
+    printf("==================== parallel differentiation ====================\n");
+    benchmark_parallel_differentiation(WIDE_SUM_TERMS);
+
+    printf("==================== fast math functions (%s kernels) ====================\n", fast_math_kernels_name());
+    // границы ошибок из fast_math.h
+    benchmark_fast_math_function("sin", sin, fast_sin_block, -100.0, 100.0, 1.0);
+    benchmark_fast_math_function("cos", cos, fast_cos_block, -100.0, 100.0, 1.0);
+    benchmark_fast_math_function("sin", sin, fast_sin_block, -FAST_TRIG_LIMIT, FAST_TRIG_LIMIT, 2.0);
+    benchmark_fast_math_function("exp", exp, fast_exp_block, -700.0, 700.0, 1.0);
+    benchmark_fast_math_function("ln",  log, fast_ln_block,  1e-6,   1e6,   1.0);
+    benchmark_fast_math_function("ln",  log, fast_ln_block,  0.5,    2.0,   2.0);
+
+    return 0;
+}
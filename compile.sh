@@ -1,6 +1,6 @@
 #!/bin/bash
 
-files="main.cpp dump.cpp io_diff.cpp latex_dump.cpp logic_functions.cpp operations.cpp tree_base.cpp user_interface.cpp variable_parse.cpp new_input.cpp processing_diff.cpp"
+files="main.cpp dump.cpp io_diff.cpp latex_dump.cpp logic_functions.cpp operations.cpp tree_base.cpp user_interface.cpp variable_parse.cpp new_input.cpp processing_diff.cpp compiled_expression.cpp batch_eval.cpp jit_codegen.cpp thread_pool.cpp parallel_eval.cpp incremental_eval.cpp sweep_eval.cpp power_reduction.cpp fast_math.cpp reverse_ad.cpp forward_ad.cpp taylor_eval.cpp symbolic_derivatives.cpp rewrite_rules.cpp egraph.cpp like_terms.cpp polynomial_form.cpp"
 
 flags="-D _DEBUG -ggdb3 -std=c++17 -O0 -Wall -Wextra -Weffc++ -Waggressive-loop-optimizations \
     -Wc++14-compat -Wmissing-declarations -Wcast-align -Wcast-qual -Wchar-subscripts \
@@ -16,4 +16,4 @@ flags="-D _DEBUG -ggdb3 -std=c++17 -O0 -Wall -Wextra -Weffc++ -Waggressive-loop-
     -fstack-protector -fstrict-overflow -flto-odr-type-merging -fno-omit-frame-pointer \
     -Wlarger-than=8192 -Wstack-usage=8192 -pie -fPIE -Werror=vla \
     -fsanitize=address,alignment,bool,bounds,enum,float-cast-overflow,float-divide-by-zero,integer-divide-by-zero,leak,nonnull-attribute,null,object-size,return,returns-nonnull-attribute,shift,signed-integer-overflow,undefined,unreachable,vla-bound,vptr"
-g++ -I./include $files -o differentiator $flags
+g++ -I./include $files -o differentiator $flags -ldl -pthread
@@ -0,0 +1,335 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "tree_base.h"
+#include "logic_functions.h"
+#include "typed_eval.h"
+#include "compiled_expression.h"
+
+const size_t INITIAL_PROGRAM_CAPACITY = 32;
+
+// Уже выписанные инструкции по содержимому. Операнды - слоты, поэтому равные поддеревья
+// дают равные инструкции и получают один слот: программа становится DAG,
+// и общее подвыражение вычисляется один раз за вычисление
+struct instruction_table
+{
+    int*   slots;     // номер инструкции + 1, 0 - пустая ячейка
+    size_t capacity;
+    size_t used;
+};
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static tree_error_type append_instruction(compiled_expression* expr, instruction_t instruction, int* slot)
+{
+    assert(expr != NULL);
+    assert(slot != NULL);
+
+    if (expr -> size == expr -> capacity)
+    {
+        size_t new_capacity = (expr -> capacity == 0) ? INITIAL_PROGRAM_CAPACITY : expr -> capacity * 2;
+
+        instruction_t* new_instructions = (instruction_t*)realloc(expr -> instructions,
+                                                                  new_capacity * sizeof(instruction_t));
+        if (new_instructions == NULL)
+            return TREE_ERROR_ALLOCATION;
+
+        expr -> instructions = new_instructions;
+        expr -> capacity     = new_capacity;
+    }
+
+    expr -> instructions[expr -> size] = instruction;
+    *slot = (int)expr -> size;
+    expr -> size++;
+
+    return TREE_ERROR_NO;
+}
+
+
+static instruction_code operation_to_instruction(operation_type op)
+{
+    switch (op)
+    {
+        case OP_ADD: return INSTR_ADD;
+        case OP_SUB: return INSTR_SUB;
+        case OP_MUL: return INSTR_MUL;
+        case OP_DIV: return INSTR_DIV;
+        case OP_SIN: return INSTR_SIN;
+        case OP_COS: return INSTR_COS;
+        case OP_POW: return INSTR_POW;
+        case OP_LN:  return INSTR_LN;
+        case OP_EXP: return INSTR_EXP;
+        default:     return INSTR_NUM;
+    }
+}
+
+
+bool is_unary_instruction(instruction_code code)
+{
+    return (code == INSTR_SIN || code == INSTR_COS || code == INSTR_LN || code == INSTR_EXP);
+}
+
+
+static size_t hash_combine(size_t hash, size_t value)
+{
+    return hash * 33 + value;
+}
+
+
+static size_t hash_instruction(const instruction_t* instruction)
+{
+    size_t value_bits = 0;
+    memcpy(&value_bits, &instruction -> value, sizeof(value_bits));
+
+    size_t hash = 5381;
+    hash = hash_combine(hash, (size_t)instruction -> code);
+    hash = hash_combine(hash, (size_t)(instruction -> left  + 1));
+    hash = hash_combine(hash, (size_t)(instruction -> right + 1));
+    hash = hash_combine(hash, (size_t)(instruction -> variable + 1));
+    hash = hash_combine(hash, value_bits);
+
+    // числа различаются старшими битами, а ячейка выбирается младшими
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    return hash ^ (hash >> 32);
+}
+
+
+static bool instructions_equal(const instruction_t* first, const instruction_t* second)
+{
+    return first -> code     == second -> code     &&
+           first -> left     == second -> left     &&
+           first -> right    == second -> right    &&
+           first -> variable == second -> variable &&
+           memcmp(&first -> value, &second -> value, sizeof(first -> value)) == 0;
+}
+
+
+static void insert_instruction(instruction_table* table, const compiled_expression* expr, int slot)
+{
+    size_t mask = table -> capacity - 1;
+    size_t i    = hash_instruction(&expr -> instructions[slot]) & mask;
+
+    while (table -> slots[i] != 0)
+        i = (i + 1) & mask;
+
+    table -> slots[i] = slot + 1;
+    table -> used++;
+}
+
+
+static tree_error_type grow_instruction_table(instruction_table* table, const compiled_expression* expr)
+{
+    size_t capacity = (table -> capacity == 0) ? 2 * INITIAL_PROGRAM_CAPACITY : 2 * table -> capacity;
+
+    int* slots = (int*)calloc(capacity, sizeof(int));
+    if (slots == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    free(table -> slots);
+    table -> slots    = slots;
+    table -> capacity = capacity;
+    table -> used     = 0;
+
+    for (size_t i = 0; i < expr -> size; i++)
+        insert_instruction(table, expr, (int)i);
+
+    return TREE_ERROR_NO;
+}
+
+
+// Слот равной инструкции, если она уже есть в программе, иначе новая инструкция
+static tree_error_type append_unique_instruction(compiled_expression* expr, instruction_table* table,
+                                                 instruction_t instruction, int* slot)
+{
+    if (2 * (table -> used + 1) > table -> capacity)
+    {
+        tree_error_type error = grow_instruction_table(table, expr);
+        if (error != TREE_ERROR_NO)
+            return error;
+    }
+
+    size_t mask = table -> capacity - 1;
+    size_t i    = hash_instruction(&instruction) & mask;
+
+    for (; table -> slots[i] != 0; i = (i + 1) & mask)
+    {
+        if (instructions_equal(&expr -> instructions[table -> slots[i] - 1], &instruction))
+        {
+            *slot = table -> slots[i] - 1;
+            return TREE_ERROR_NO;
+        }
+    }
+
+    tree_error_type error = append_instruction(expr, instruction, slot);
+    if (error != TREE_ERROR_NO)
+        return error;
+
+    table -> slots[i] = *slot + 1;
+    table -> used++;
+
+    return TREE_ERROR_NO;
+}
+
+
+static tree_error_type compile_node(node_t* node, variable_table* var_table, compiled_expression* expr,
+                                    instruction_table* table, int* slot)
+{
+    if (node == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    instruction_t instruction = {INSTR_NUM, NO_OPERAND, NO_OPERAND, NO_OPERAND, 0.0};
+    tree_error_type error = TREE_ERROR_NO;
+
+    switch (node -> type)
+    {
+        case NODE_NUM:
+            instruction.value = node -> data.num_value;
+            break;
+
+        case NODE_VAR:
+            if (node -> data.var_definition.name == NULL)
+                return TREE_ERROR_VARIABLE_NOT_FOUND;
+
+            instruction.code     = INSTR_VAR;
+            instruction.variable = find_variable_by_name(var_table, node -> data.var_definition.name);
+            if (instruction.variable == OPERATION_FAILED)
+                return TREE_ERROR_VARIABLE_NOT_FOUND;
+            break;
+
+        case NODE_OP:
+            if (node -> right == NULL)
+                return TREE_ERROR_NULL_PTR;
+
+            instruction.code = operation_to_instruction(node -> data.op_value);
+
+            if (instruction.code == INSTR_POW && node -> right -> type == NODE_NUM &&
+                is_reducible_exponent(node -> right -> data.num_value))
+            {
+                instruction.code  = INSTR_POWI;
+                instruction.value = node -> right -> data.num_value;
+            }
+
+            if (!is_unary_instruction(instruction.code))
+            {
+                if (node -> left == NULL)
+                    return TREE_ERROR_NULL_PTR;
+
+                error = compile_node(node -> left, var_table, expr, table, &instruction.left);
+                if (error != TREE_ERROR_NO)
+                    return error;
+            }
+
+            // показатель INSTR_POWI хранится в value, слот для него не нужен
+            if (instruction.code != INSTR_POWI)
+            {
+                error = compile_node(node -> right, var_table, expr, table, &instruction.right);
+                if (error != TREE_ERROR_NO)
+                    return error;
+            }
+            break;
+
+        default:
+            return TREE_ERROR_UNKNOWN_OPERATION;
+    }
+
+    return append_unique_instruction(expr, table, instruction, slot);
+}
+
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type compiled_expression_constructor(compiled_expression* expr)
+{
+    if (expr == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    expr -> instructions        = NULL;
+    expr -> size                = 0;
+    expr -> capacity            = 0;
+    expr -> result              = NO_OPERAND;
+    expr -> number_of_variables = 0;
+
+    return TREE_ERROR_NO;
+}
+
+
+tree_error_type compiled_expression_destructor(compiled_expression* expr)
+{
+    if (expr == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    free(expr -> instructions);
+
+    return compiled_expression_constructor(expr);
+}
+
+
+tree_error_type compile_tree(tree_t* tree, variable_table* var_table, compiled_expression* expr)
+{
+    if (tree == NULL || var_table == NULL || expr == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (tree -> root == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    expr -> size = 0;
+    expr -> number_of_variables = var_table -> number_of_variables;
+
+    instruction_table table = {};
+
+    tree_error_type error = compile_node(tree -> root, var_table, expr, &table, &expr -> result);
+    free(table.slots);
+
+    if (error != TREE_ERROR_NO)
+    {
+        compiled_expression_destructor(expr);
+        return error;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+tree_error_type execute_instruction(const compiled_expression* expr, size_t index,
+                                    const double* variables, double* slots)
+{
+    assert(expr  != NULL);
+    assert(slots != NULL);
+
+    return execute_instruction_as(expr, index, variables, slots);
+}
+
+
+tree_error_type evaluate_compiled(const compiled_expression* expr, const double* variables,
+                                  double* slots, double* result)
+{
+    return evaluate_compiled_as(expr, variables, slots, result);
+}
+
+
+size_t hash_compiled_expression(const compiled_expression* expr)
+{
+    assert(expr != NULL);
+
+    size_t hash = 5381;
+
+    for (size_t i = 0; i < expr -> size; i++)
+    {
+        const instruction_t* instruction = &expr -> instructions[i];
+
+        size_t value_bits = 0;
+        memcpy(&value_bits, &instruction -> value, sizeof(value_bits));
+
+        hash = hash_combine(hash, (size_t)instruction -> code);
+        hash = hash_combine(hash, (size_t)(instruction -> left  + 1));
+        hash = hash_combine(hash, (size_t)(instruction -> right + 1));
+        hash = hash_combine(hash, (size_t)(instruction -> variable + 1));
+        hash = hash_combine(hash, value_bits);
+    }
+
+    return hash_combine(hash, (size_t)expr -> result);
+}
@@ -0,0 +1,59 @@
+#ifndef COMPILED_EXPRESSION_H_
+#define COMPILED_EXPRESSION_H_
+
+#include <stddef.h>
+
+#include "tree_common.h"
+#include "variable_parse.h"
+#include "tree_error_types.h"
+
+#define NO_OPERAND -1
+
+enum instruction_code
+{
+    INSTR_NUM,
+    INSTR_VAR,
+    INSTR_ADD,
+    INSTR_SUB,
+    INSTR_MUL,
+    INSTR_DIV,
+    INSTR_SIN,
+    INSTR_COS,
+    INSTR_POW,
+    INSTR_LN,
+    INSTR_EXP,
+    INSTR_POWI     // POW с постоянным показателем из value (см. power_reduction.h), right = NO_OPERAND
+};
+
+// Инструкция пишет результат в слот со своим номером,
+// операнды - номера слотов более ранних инструкций. Слот может быть операндом
+// нескольких инструкций: compile_tree выписывает общие подвыражения один раз
+struct instruction_t
+{
+    instruction_code code;
+    int              left;
+    int              right;
+    int              variable;  // индекс в variable_table для INSTR_VAR
+    double           value;     // значение для INSTR_NUM, показатель для INSTR_POWI
+};
+
+struct compiled_expression
+{
+    instruction_t* instructions;
+    size_t         size;
+    size_t         capacity;
+    int            result;
+    int            number_of_variables;
+};
+
+tree_error_type compiled_expression_constructor(compiled_expression* expr);
+tree_error_type compiled_expression_destructor (compiled_expression* expr);
+tree_error_type compile_tree(tree_t* tree, variable_table* var_table, compiled_expression* expr);
+tree_error_type execute_instruction(const compiled_expression* expr, size_t index,
+                                    const double* variables, double* slots);
+tree_error_type evaluate_compiled(const compiled_expression* expr, const double* variables,
+                                  double* slots, double* result);
+bool            is_unary_instruction(instruction_code code);
+size_t          hash_compiled_expression(const compiled_expression* expr);
+
+#endif // COMPILED_EXPRESSION_H_
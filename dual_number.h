@@ -0,0 +1,93 @@
+#ifndef DUAL_NUMBER_H_
+#define DUAL_NUMBER_H_
+
+#include <math.h>
+
+// Дуальное число value + derivative * e, e^2 = 0: арифметика над ним
+// переносит вместе со значением производную по одному направлению
+struct dual_number
+{
+    double value;
+    double derivative;
+};
+
+inline dual_number make_dual(double value, double derivative)
+{
+    dual_number result = {value, derivative};
+    return result;
+}
+
+
+inline dual_number operator+(dual_number left, dual_number right)
+{
+    return make_dual(left.value + right.value, left.derivative + right.derivative);
+}
+
+
+inline dual_number operator-(dual_number left, dual_number right)
+{
+    return make_dual(left.value - right.value, left.derivative - right.derivative);
+}
+
+
+inline dual_number operator*(dual_number left, dual_number right)
+{
+    return make_dual(left.value * right.value, left.derivative * right.value + left.value * right.derivative);
+}
+
+
+inline dual_number operator/(dual_number left, dual_number right)
+{
+    double quotient = left.value / right.value;
+
+    return make_dual(quotient, (left.derivative - quotient * right.derivative) / right.value);
+}
+
+
+inline dual_number dual_sin(dual_number argument)
+{
+    return make_dual(sin(argument.value), cos(argument.value) * argument.derivative);
+}
+
+
+inline dual_number dual_cos(dual_number argument)
+{
+    return make_dual(cos(argument.value), -sin(argument.value) * argument.derivative);
+}
+
+
+inline dual_number dual_exp(dual_number argument)
+{
+    double value = exp(argument.value);
+
+    return make_dual(value, value * argument.derivative);
+}
+
+
+inline dual_number dual_ln(dual_number argument)
+{
+    return make_dual(log(argument.value), argument.derivative / argument.value);
+}
+
+
+inline dual_number dual_sqrt(dual_number argument)
+{
+    double value = sqrt(argument.value);
+
+    return make_dual(value, argument.derivative / (2.0 * value));
+}
+
+
+// d(u^v) = v * u^(v-1) * du + u^v * ln(u) * dv; ln(u) нужен только при u > 0
+inline dual_number dual_pow(dual_number base, dual_number exponent)
+{
+    double value      = pow(base.value, exponent.value);
+    double derivative = exponent.value * pow(base.value, exponent.value - 1.0) * base.derivative;
+
+    if (base.value > 0)
+        derivative += value * log(base.value) * exponent.derivative;
+
+    return make_dual(value, derivative);
+}
+
+#endif // DUAL_NUMBER_H_
@@ -0,0 +1,989 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "egraph.h"
+#include "operations.h"
+#include "logic_functions.h"
+#include "power_reduction.h"
+
+// Номер класса - номер узла-представителя в union-find
+const size_t EGRAPH_NONE = SIZE_MAX;
+
+// Стоимости извлечения - примерная цена операции в тактах
+const double LEAF_COST           = 1.0;
+const double ARITHMETIC_COST     = 2.0;
+const double DIVISION_COST       = 8.0;
+const double REDUCED_POWER_COST  = 6.0;
+const double POWER_COST          = 24.0;
+const double TRANSCENDENTAL_COST = 20.0;
+
+struct enode
+{
+    node_type      type;
+    operation_type op;
+    double         number;
+    const char*    name;       // имя переменной принадлежит исходному дереву
+    size_t         name_hash;
+    size_t         left;       // классы операндов, EGRAPH_NONE - операнда нет
+    size_t         right;
+    bool           dead;       // повтор другого узла после слияния классов
+};
+
+struct egraph
+{
+    enode*          nodes;
+    size_t*         parent;
+    size_t          size;
+    size_t          capacity;
+    size_t          max_nodes;      // 0 - предел ещё не действует (добавляется исходное дерево)
+    bool            limit_reached;
+    size_t          changes;        // новые узлы и слияния классов за итерацию
+    tree_error_type error;
+
+    size_t*         table;          // номер узла + 1, 0 - пустая ячейка
+    size_t          table_capacity;
+    size_t          table_used;
+
+    // Снимок классов на начало итерации: узлы класса c - members[begin[c]..begin[c + 1])
+    size_t*         members;
+    size_t*         begin;
+    bool*           has_number;
+    double*         number;
+    size_t          snapshot_size;
+
+    double*         costs;
+    size_t*         best;
+};
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static size_t egraph_find(egraph* graph, size_t id)
+{
+    while (graph -> parent[id] != id)
+    {
+        graph -> parent[id] = graph -> parent[graph -> parent[id]];
+        id = graph -> parent[id];
+    }
+
+    return id;
+}
+
+
+static size_t canonical(egraph* graph, size_t id)
+{
+    return (id == EGRAPH_NONE) ? EGRAPH_NONE : egraph_find(graph, id);
+}
+
+
+static bool same_class(egraph* graph, size_t first, size_t second)
+{
+    return first != EGRAPH_NONE && second != EGRAPH_NONE && egraph_find(graph, first) == egraph_find(graph, second);
+}
+
+
+static bool egraph_union(egraph* graph, size_t first, size_t second)
+{
+    if (first == EGRAPH_NONE || second == EGRAPH_NONE)
+        return false;
+
+    first  = egraph_find(graph, first);
+    second = egraph_find(graph, second);
+    if (first == second)
+        return false;
+
+    // представитель - старший по возрасту узел
+    if (second < first)
+    {
+        size_t temp = first;
+        first  = second;
+        second = temp;
+    }
+
+    graph -> parent[second] = first;
+    graph -> changes++;
+
+    return true;
+}
+
+
+static size_t hash_enode(egraph* graph, const enode* node)
+{
+    size_t hash = mix_hash((size_t)node -> type + 1, (size_t)node -> op);
+
+    switch (node -> type)
+    {
+        case NODE_NUM:
+        {
+            double number = node -> number + 0.0;
+            uint64_t bits = 0;
+            memcpy(&bits, &number, sizeof(bits));
+            return mix_hash(hash, bits);
+        }
+        case NODE_VAR:
+            return mix_hash(hash, node -> name_hash);
+        case NODE_OP:
+            hash = mix_hash(hash, canonical(graph, node -> left));
+            return mix_hash(hash, canonical(graph, node -> right));
+        default:
+            return hash;
+    }
+}
+
+
+static bool enodes_equal(egraph* graph, const enode* first, const enode* second)
+{
+    if (first -> type != second -> type)
+        return false;
+
+    switch (first -> type)
+    {
+        case NODE_NUM:
+            return !(first -> number < second -> number) && !(first -> number > second -> number);
+        case NODE_VAR:
+            return first -> name_hash == second -> name_hash && strcmp(first -> name, second -> name) == 0;
+        case NODE_OP:
+            return first -> op == second -> op &&
+                   canonical(graph, first -> left)  == canonical(graph, second -> left) &&
+                   canonical(graph, first -> right) == canonical(graph, second -> right);
+        default:
+            return false;
+    }
+}
+
+
+static size_t egraph_lookup(egraph* graph, const enode* node)
+{
+    if (graph -> table_capacity == 0)
+        return EGRAPH_NONE;
+
+    size_t mask = graph -> table_capacity - 1;
+
+    for (size_t i = hash_enode(graph, node) & mask; graph -> table[i] != 0; i = (i + 1) & mask)
+        if (enodes_equal(graph, &graph -> nodes[graph -> table[i] - 1], node))
+            return graph -> table[i] - 1;
+
+    return EGRAPH_NONE;
+}
+
+
+static void egraph_insert(egraph* graph, size_t id)
+{
+    size_t mask = graph -> table_capacity - 1;
+    size_t i    = hash_enode(graph, &graph -> nodes[id]) & mask;
+
+    while (graph -> table[i] != 0)
+        i = (i + 1) & mask;
+
+    graph -> table[i] = id + 1;
+    graph -> table_used++;
+}
+
+
+// Таблица строится заново: живые узлы вставляются с текущими классами операндов
+static bool egraph_rehash(egraph* graph, size_t capacity)
+{
+    size_t* table = (size_t*)calloc(capacity, sizeof(size_t));
+    if (table == NULL)
+    {
+        graph -> error = TREE_ERROR_ALLOCATION;
+        return false;
+    }
+
+    free(graph -> table);
+    graph -> table          = table;
+    graph -> table_capacity = capacity;
+    graph -> table_used     = 0;
+
+    for (size_t i = 0; i < graph -> size; i++)
+        if (!graph -> nodes[i].dead)
+            egraph_insert(graph, i);
+
+    return true;
+}
+
+
+static bool egraph_reserve(egraph* graph)
+{
+    if (graph -> size < graph -> capacity)
+        return true;
+
+    size_t capacity = (graph -> capacity == 0) ? 64 : 2 * graph -> capacity;
+
+    enode* nodes = (enode*)realloc(graph -> nodes, capacity * sizeof(enode));
+    if (nodes == NULL)
+    {
+        graph -> error = TREE_ERROR_ALLOCATION;
+        return false;
+    }
+    graph -> nodes = nodes;
+
+    size_t* parent = (size_t*)realloc(graph -> parent, capacity * sizeof(size_t));
+    if (parent == NULL)
+    {
+        graph -> error = TREE_ERROR_ALLOCATION;
+        return false;
+    }
+    graph -> parent   = parent;
+    graph -> capacity = capacity;
+
+    return true;
+}
+
+
+// Возвращает класс узла, равного node, добавляя узел при необходимости
+static size_t egraph_add(egraph* graph, enode node)
+{
+    if (graph -> error != TREE_ERROR_NO)
+        return EGRAPH_NONE;
+
+    node.left  = canonical(graph, node.left);
+    node.right = canonical(graph, node.right);
+    node.dead  = false;
+
+    size_t existing = egraph_lookup(graph, &node);
+    if (existing != EGRAPH_NONE)
+        return egraph_find(graph, existing);
+
+    if (graph -> max_nodes != 0 && graph -> size >= graph -> max_nodes)
+    {
+        graph -> limit_reached = true;
+        return EGRAPH_NONE;
+    }
+
+    if (!egraph_reserve(graph))
+        return EGRAPH_NONE;
+
+    if (2 * (graph -> table_used + 1) > graph -> table_capacity &&
+        !egraph_rehash(graph, (graph -> table_capacity == 0) ? 128 : 2 * graph -> table_capacity))
+        return EGRAPH_NONE;
+
+    size_t id = graph -> size++;
+    graph -> nodes[id]  = node;
+    graph -> parent[id] = id;
+    graph -> changes++;
+    egraph_insert(graph, id);
+
+    return id;
+}
+
+
+static size_t add_number(egraph* graph, double number)
+{
+    enode node = {};
+    node.type   = NODE_NUM;
+    node.number = number;
+    node.left   = EGRAPH_NONE;
+    node.right  = EGRAPH_NONE;
+
+    return egraph_add(graph, node);
+}
+
+
+static size_t add_operation(egraph* graph, operation_type op, size_t left, size_t right)
+{
+    if (right == EGRAPH_NONE || (is_binary(op) && left == EGRAPH_NONE))
+        return EGRAPH_NONE;
+
+    enode node = {};
+    node.type  = NODE_OP;
+    node.op    = op;
+    node.left  = is_binary(op) ? left : EGRAPH_NONE;
+    node.right = right;
+
+    return egraph_add(graph, node);
+}
+
+
+static size_t add_subtree(egraph* graph, const node_t* node)
+{
+    if (node == NULL)
+        return EGRAPH_NONE;
+
+    enode added = {};
+    added.type  = node -> type;
+    added.left  = EGRAPH_NONE;
+    added.right = EGRAPH_NONE;
+
+    switch (node -> type)
+    {
+        case NODE_NUM:
+            added.number = node -> data.num_value;
+            break;
+
+        case NODE_VAR:
+            added.name      = node -> data.var_definition.name;
+            added.name_hash = node -> data.var_definition.hash;
+            break;
+
+        case NODE_OP:
+            added.op    = node -> data.op_value;
+            added.left  = add_subtree(graph, node -> left);
+            added.right = add_subtree(graph, node -> right);
+            if ((node -> left != NULL && added.left == EGRAPH_NONE) || added.right == EGRAPH_NONE)
+                return EGRAPH_NONE;
+            break;
+
+        default:
+            graph -> error = TREE_ERROR_UNKNOWN_OPERATION;
+            return EGRAPH_NONE;
+    }
+
+    return egraph_add(graph, added);
+}
+
+
+// Восстанавливает конгруэнтность: узлы с равными операциями над равными классами
+// сливаются, пока слияния порождают новые совпадения
+static void egraph_rebuild(egraph* graph)
+{
+    bool merged = true;
+
+    while (merged && graph -> error == TREE_ERROR_NO)
+    {
+        merged = false;
+
+        memset(graph -> table, 0, graph -> table_capacity * sizeof(size_t));
+        graph -> table_used = 0;
+
+        for (size_t i = 0; i < graph -> size; i++)
+        {
+            enode* node = &graph -> nodes[i];
+            if (node -> dead)
+                continue;
+
+            node -> left  = canonical(graph, node -> left);
+            node -> right = canonical(graph, node -> right);
+
+            size_t existing = egraph_lookup(graph, node);
+            if (existing != EGRAPH_NONE)
+            {
+                merged |= egraph_union(graph, existing, i);
+                node -> dead = true;
+            }
+            else
+                egraph_insert(graph, i);
+        }
+    }
+}
+
+
+static bool egraph_take_snapshot(egraph* graph)
+{
+    size_t size = graph -> size;
+
+    size_t* members    = (size_t*)realloc(graph -> members,    (size + 1) * sizeof(size_t));
+    size_t* begin      = (size_t*)realloc(graph -> begin,      (size + 2) * sizeof(size_t));
+    bool*   has_number = (bool*)  realloc(graph -> has_number, (size + 1) * sizeof(bool));
+    double* number     = (double*)realloc(graph -> number,     (size + 1) * sizeof(double));
+
+    if (members    != NULL) graph -> members    = members;
+    if (begin      != NULL) graph -> begin      = begin;
+    if (has_number != NULL) graph -> has_number = has_number;
+    if (number     != NULL) graph -> number     = number;
+
+    if (members == NULL || begin == NULL || has_number == NULL || number == NULL)
+    {
+        graph -> error = TREE_ERROR_ALLOCATION;
+        return false;
+    }
+
+    memset(begin,      0, (size + 2) * sizeof(size_t));
+    memset(has_number, 0, (size + 1) * sizeof(bool));
+
+    // сортировка подсчётом по представителю: begin[c + 2] считает узлы класса c,
+    // после префиксных сумм begin[c + 1] служит курсором заполнения и становится началом класса c + 1
+    for (size_t i = 0; i < size; i++)
+        if (!graph -> nodes[i].dead)
+            begin[egraph_find(graph, i) + 2]++;
+
+    for (size_t c = 2; c < size + 2; c++)
+        begin[c] += begin[c - 1];
+
+    for (size_t i = 0; i < size; i++)
+    {
+        if (graph -> nodes[i].dead)
+            continue;
+
+        size_t c = egraph_find(graph, i);
+        members[begin[c + 1]++] = i;
+
+        if (graph -> nodes[i].type == NODE_NUM)
+        {
+            has_number[c] = true;
+            number[c]     = graph -> nodes[i].number;
+        }
+    }
+
+    graph -> snapshot_size = size;
+
+    return true;
+}
+
+
+static void class_members(const egraph* graph, size_t id, size_t* first, size_t* last)
+{
+    *first = 0;
+    *last  = 0;
+
+    if (id != EGRAPH_NONE && id < graph -> snapshot_size)
+    {
+        *first = graph -> begin[id];
+        *last  = graph -> begin[id + 1];
+    }
+}
+
+
+static bool class_number(const egraph* graph, size_t id, double* number)
+{
+    if (id == EGRAPH_NONE || id >= graph -> snapshot_size || !graph -> has_number[id])
+        return false;
+
+    *number = graph -> number[id];
+    return true;
+}
+
+
+static bool class_is(const egraph* graph, size_t id, bool (*predicate)(double))
+{
+    double number = 0.0;
+    return class_number(graph, id, &number) && predicate(number);
+}
+
+// ==================== ПРАВИЛА ====================
+
+static void apply_fold_rule(egraph* graph, size_t id, const enode* node)
+{
+    double left_val  = 0.0;
+    double right_val = 0.0;
+    double result    = 0.0;
+
+    if (!class_number(graph, node -> right, &right_val))
+        return;
+
+    if (node -> left != EGRAPH_NONE && !class_number(graph, node -> left, &left_val))
+        return;
+
+    if (fold_numbers(node -> op, left_val, right_val, &result))
+        egraph_union(graph, id, add_number(graph, result));
+}
+
+
+static void apply_neutral_rules(egraph* graph, size_t id, const enode* node)
+{
+    size_t left  = node -> left;
+    size_t right = node -> right;
+
+    switch (node -> op)
+    {
+        case OP_ADD:
+            if (class_is(graph, right, is_zero)) egraph_union(graph, id, left);
+            if (class_is(graph, left,  is_zero)) egraph_union(graph, id, right);
+            break;
+
+        case OP_SUB:
+            if (class_is(graph, right, is_zero)) egraph_union(graph, id, left);
+            if (same_class(graph, left, right))  egraph_union(graph, id, add_number(graph, 0.0));
+            break;
+
+        case OP_MUL:
+            if (class_is(graph, right, is_one)) egraph_union(graph, id, left);
+            if (class_is(graph, left,  is_one)) egraph_union(graph, id, right);
+            if (class_is(graph, left, is_zero) || class_is(graph, right, is_zero))
+                egraph_union(graph, id, add_number(graph, 0.0));
+            break;
+
+        case OP_DIV:
+            if (class_is(graph, right, is_one)) egraph_union(graph, id, left);
+            break;
+
+        case OP_POW:
+            if (class_is(graph, right, is_one))  egraph_union(graph, id, left);
+            if (class_is(graph, right, is_zero)) egraph_union(graph, id, add_number(graph, 1.0));
+            if (class_is(graph, left,  is_one))  egraph_union(graph, id, add_number(graph, 1.0));
+            break;
+
+        case OP_SIN:
+        case OP_COS:
+        case OP_LN:
+        case OP_EXP:
+        default:
+            break;
+    }
+}
+
+
+// a + b = b + a, a * b = b * a; (a + b) + c = a + (b + c) и так же для умножения
+static void apply_commutative_rules(egraph* graph, size_t id, const enode* node)
+{
+    if (node -> op != OP_ADD && node -> op != OP_MUL)
+        return;
+
+    egraph_union(graph, id, add_operation(graph, node -> op, node -> right, node -> left));
+
+    size_t first = 0, last = 0;
+    class_members(graph, node -> left, &first, &last);
+
+    for (size_t k = first; k < last && !graph -> limit_reached; k++)
+    {
+        enode inner = graph -> nodes[graph -> members[k]];
+        if (inner.type == NODE_OP && inner.op == node -> op)
+            egraph_union(graph, id, add_operation(graph, node -> op, inner.left,
+                                                  add_operation(graph, node -> op, inner.right, node -> right)));
+    }
+}
+
+
+// a * (b ± c) = a * b ± a * c
+static void apply_distributive_rule(egraph* graph, size_t id, const enode* node)
+{
+    if (node -> op != OP_MUL)
+        return;
+
+    size_t first = 0, last = 0;
+    class_members(graph, node -> right, &first, &last);
+
+    for (size_t k = first; k < last && !graph -> limit_reached; k++)
+    {
+        enode sum = graph -> nodes[graph -> members[k]];
+        if (sum.type == NODE_OP && (sum.op == OP_ADD || sum.op == OP_SUB))
+            egraph_union(graph, id, add_operation(graph, sum.op,
+                                                  add_operation(graph, OP_MUL, node -> left, sum.left),
+                                                  add_operation(graph, OP_MUL, node -> left, sum.right)));
+    }
+}
+
+
+// Общий множитель двух произведений: common * first_rest и common * second_rest
+static bool find_common_factor(egraph* graph, const enode* first, const enode* second,
+                               size_t* common, size_t* first_rest, size_t* second_rest)
+{
+    size_t first_factors[2]  = {first -> left,  first -> right};
+    size_t second_factors[2] = {second -> left, second -> right};
+
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+            if (same_class(graph, first_factors[i], second_factors[j]))
+            {
+                *common      = first_factors[i];
+                *first_rest  = first_factors[1 - i];
+                *second_rest = second_factors[1 - j];
+                return true;
+            }
+
+    return false;
+}
+
+
+// a * b ± a * c = a * (b ± c), a ± a * c = a * (1 ± c), a / c ± b / c = (a ± b) / c
+static void apply_factoring_rules(egraph* graph, size_t id, const enode* node)
+{
+    if (node -> op != OP_ADD && node -> op != OP_SUB)
+        return;
+
+    size_t left_first  = 0, left_last  = 0;
+    size_t right_first = 0, right_last = 0;
+    class_members(graph, node -> left,  &left_first,  &left_last);
+    class_members(graph, node -> right, &right_first, &right_last);
+
+    enode whole_left  = {};
+    enode whole_right = {};
+    whole_left.left   = node -> left;
+    whole_left.right  = EGRAPH_NONE;
+    whole_right.left  = node -> right;
+    whole_right.right = EGRAPH_NONE;
+
+    for (size_t k = left_first; k < left_last && !graph -> limit_reached; k++)
+    {
+        enode left = graph -> nodes[graph -> members[k]];
+        if (left.type != NODE_OP)
+            continue;
+
+        size_t common = 0, left_rest = 0, right_rest = 0;
+
+        if (left.op == OP_MUL && find_common_factor(graph, &left, &whole_right, &common, &left_rest, &right_rest))
+            egraph_union(graph, id, add_operation(graph, OP_MUL, common,
+                                                  add_operation(graph, node -> op, left_rest, add_number(graph, 1.0))));
+
+        for (size_t m = right_first; m < right_last && !graph -> limit_reached; m++)
+        {
+            enode right = graph -> nodes[graph -> members[m]];
+            if (right.type != NODE_OP || right.op != left.op)
+                continue;
+
+            if (left.op == OP_MUL && find_common_factor(graph, &left, &right, &common, &left_rest, &right_rest))
+                egraph_union(graph, id, add_operation(graph, OP_MUL, common,
+                                                      add_operation(graph, node -> op, left_rest, right_rest)));
+
+            if (left.op == OP_DIV && same_class(graph, left.right, right.right))
+                egraph_union(graph, id, add_operation(graph, OP_DIV,
+                                                      add_operation(graph, node -> op, left.left, right.left), left.right));
+        }
+    }
+
+    for (size_t m = right_first; m < right_last && !graph -> limit_reached; m++)
+    {
+        enode right = graph -> nodes[graph -> members[m]];
+        size_t common = 0, left_rest = 0, right_rest = 0;
+
+        if (right.type == NODE_OP && right.op == OP_MUL &&
+            find_common_factor(graph, &whole_left, &right, &common, &left_rest, &right_rest))
+            egraph_union(graph, id, add_operation(graph, OP_MUL, common,
+                                                  add_operation(graph, node -> op, add_number(graph, 1.0), right_rest)));
+    }
+
+    // (a + b) - a = b, (a + b) - b = a
+    if (node -> op == OP_SUB)
+        for (size_t k = left_first; k < left_last; k++)
+        {
+            enode left = graph -> nodes[graph -> members[k]];
+            if (left.type != NODE_OP || left.op != OP_ADD)
+                continue;
+
+            if (same_class(graph, left.left,  node -> right)) egraph_union(graph, id, left.right);
+            if (same_class(graph, left.right, node -> right)) egraph_union(graph, id, left.left);
+        }
+}
+
+
+// a * a = a^2, a * a^k = a^(k + 1), a^k * a^m = a^(k + m)
+static void apply_power_rules(egraph* graph, size_t id, const enode* node)
+{
+    if (node -> op != OP_MUL)
+        return;
+
+    if (same_class(graph, node -> left, node -> right))
+        egraph_union(graph, id, add_operation(graph, OP_POW, node -> left, add_number(graph, 2.0)));
+
+    size_t left_first  = 0, left_last  = 0;
+    size_t right_first = 0, right_last = 0;
+    class_members(graph, node -> left,  &left_first,  &left_last);
+    class_members(graph, node -> right, &right_first, &right_last);
+
+    for (size_t m = right_first; m < right_last && !graph -> limit_reached; m++)
+    {
+        enode right = graph -> nodes[graph -> members[m]];
+        if (right.type != NODE_OP || right.op != OP_POW)
+            continue;
+
+        if (same_class(graph, right.left, node -> left))
+            egraph_union(graph, id, add_operation(graph, OP_POW, node -> left,
+                                                  add_operation(graph, OP_ADD, right.right, add_number(graph, 1.0))));
+
+        for (size_t k = left_first; k < left_last && !graph -> limit_reached; k++)
+        {
+            enode left = graph -> nodes[graph -> members[k]];
+            if (left.type == NODE_OP && left.op == OP_POW && same_class(graph, left.left, right.left))
+                egraph_union(graph, id, add_operation(graph, OP_POW, left.left,
+                                                      add_operation(graph, OP_ADD, left.right, right.right)));
+        }
+    }
+}
+
+
+// (a / b) * c = (a * c) / b, (a / b) / c = a / (b * c), ln(exp(a)) = a
+static void apply_division_rules(egraph* graph, size_t id, const enode* node)
+{
+    size_t first = 0, last = 0;
+
+    if (node -> op == OP_LN)
+    {
+        class_members(graph, node -> right, &first, &last);
+        for (size_t k = first; k < last; k++)
+            if (graph -> nodes[graph -> members[k]].type == NODE_OP && graph -> nodes[graph -> members[k]].op == OP_EXP)
+                egraph_union(graph, id, graph -> nodes[graph -> members[k]].right);
+        return;
+    }
+
+    if (node -> op != OP_MUL && node -> op != OP_DIV)
+        return;
+
+    class_members(graph, node -> left, &first, &last);
+
+    for (size_t k = first; k < last && !graph -> limit_reached; k++)
+    {
+        enode left = graph -> nodes[graph -> members[k]];
+        if (left.type != NODE_OP || left.op != OP_DIV)
+            continue;
+
+        if (node -> op == OP_MUL)
+            egraph_union(graph, id, add_operation(graph, OP_DIV, add_operation(graph, OP_MUL, left.left, node -> right),
+                                                  left.right));
+        else
+            egraph_union(graph, id, add_operation(graph, OP_DIV, left.left,
+                                                  add_operation(graph, OP_MUL, left.right, node -> right)));
+    }
+}
+
+
+static void apply_rules(egraph* graph, size_t id)
+{
+    // узел копируется: добавление узлов может перенести массив
+    enode node = graph -> nodes[id];
+    if (node.dead || node.type != NODE_OP)
+        return;
+
+    apply_fold_rule        (graph, id, &node);
+    apply_neutral_rules    (graph, id, &node);
+    apply_commutative_rules(graph, id, &node);
+    apply_distributive_rule(graph, id, &node);
+    apply_factoring_rules  (graph, id, &node);
+    apply_power_rules      (graph, id, &node);
+    apply_division_rules   (graph, id, &node);
+}
+
+// ==================== ИЗВЛЕЧЕНИЕ ====================
+
+static double operation_cost(operation_type op, bool reduced_power)
+{
+    switch (op)
+    {
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+            return ARITHMETIC_COST;
+        case OP_DIV:
+            return DIVISION_COST;
+        case OP_POW:
+            return reduced_power ? REDUCED_POWER_COST : POWER_COST;
+        case OP_SIN:
+        case OP_COS:
+        case OP_LN:
+        case OP_EXP:
+            return TRANSCENDENTAL_COST;
+        default:
+            return POWER_COST;
+    }
+}
+
+
+static double enode_cost(egraph* graph, const enode* node)
+{
+    if (node -> type != NODE_OP)
+        return LEAF_COST;
+
+    double exponent = 0.0;
+    bool reduced_power = node -> op == OP_POW && class_number(graph, node -> right, &exponent) &&
+                         is_reducible_exponent(exponent);
+
+    double cost = operation_cost(node -> op, reduced_power) + graph -> costs[egraph_find(graph, node -> right)];
+    if (node -> left != EGRAPH_NONE)
+        cost += graph -> costs[egraph_find(graph, node -> left)];
+
+    return cost;
+}
+
+
+// Стоимость класса - минимум по его узлам; считается до неподвижной точки,
+// так как узел может ссылаться на классы, чья стоимость ещё не найдена
+static bool egraph_compute_costs(egraph* graph)
+{
+    size_t size = graph -> size;
+
+    double* costs = (double*)realloc(graph -> costs, (size + 1) * sizeof(double));
+    if (costs != NULL) graph -> costs = costs;
+    size_t* best  = (size_t*)realloc(graph -> best,  (size + 1) * sizeof(size_t));
+    if (best  != NULL) graph -> best  = best;
+
+    if (costs == NULL || best == NULL)
+    {
+        graph -> error = TREE_ERROR_ALLOCATION;
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        costs[i] = INFINITY;
+        best[i]  = EGRAPH_NONE;
+    }
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            if (graph -> nodes[i].dead)
+                continue;
+
+            size_t c    = egraph_find(graph, i);
+            double cost = enode_cost(graph, &graph -> nodes[i]);
+
+            if (cost < costs[c])
+            {
+                costs[c] = cost;
+                best[c]  = i;
+                changed  = true;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+// Лучший узел класса дороже своих операндов, поэтому спуск по best конечен
+static node_t* egraph_build_tree(egraph* graph, size_t id)
+{
+    size_t chosen = graph -> best[egraph_find(graph, id)];
+    if (chosen == EGRAPH_NONE)
+        return NULL;
+
+    enode node = graph -> nodes[chosen];
+    value_of_tree_element data = {};
+
+    switch (node.type)
+    {
+        case NODE_NUM:
+            data.num_value = node.number;
+            return create_node(NODE_NUM, data, NULL, NULL);
+
+        case NODE_VAR:
+        {
+            data.var_definition.name = strdup(node.name);
+            if (data.var_definition.name == NULL)
+                return NULL;
+
+            node_t* variable = create_node(NODE_VAR, data, NULL, NULL);
+            if (variable == NULL)
+                free(data.var_definition.name);
+
+            return variable;
+        }
+
+        case NODE_OP:
+        {
+            node_t* left = NULL;
+            if (node.left != EGRAPH_NONE && (left = egraph_build_tree(graph, node.left)) == NULL)
+                return NULL;
+
+            node_t* right = egraph_build_tree(graph, node.right);
+            if (right == NULL)
+            {
+                free_subtree(left);
+                return NULL;
+            }
+
+            data.op_value = node.op;
+            node_t* operation = create_node(NODE_OP, data, left, right);
+            if (operation == NULL)
+            {
+                free_subtree(left);
+                free_subtree(right);
+            }
+
+            return operation;
+        }
+
+        default:
+            return NULL;
+    }
+}
+
+
+static void egraph_destroy(egraph* graph)
+{
+    free(graph -> nodes);
+    free(graph -> parent);
+    free(graph -> table);
+    free(graph -> members);
+    free(graph -> begin);
+    free(graph -> has_number);
+    free(graph -> number);
+    free(graph -> costs);
+    free(graph -> best);
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+double evaluation_cost(const node_t* node)
+{
+    if (node == NULL)
+        return 0.0;
+
+    if (node -> type != NODE_OP)
+        return LEAF_COST;
+
+    bool reduced_power = node -> data.op_value == OP_POW && node -> right != NULL &&
+                         node -> right -> type == NODE_NUM && is_reducible_exponent(node -> right -> data.num_value);
+
+    return operation_cost(node -> data.op_value, reduced_power) +
+           evaluation_cost(node -> left) + evaluation_cost(node -> right);
+}
+
+
+tree_error_type simplify_tree_with_egraph(tree_t* tree, const egraph_limits* limits, egraph_stats* stats)
+{
+    if (tree == NULL || tree -> root == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    egraph_limits default_limits = {EGRAPH_DEFAULT_ITERATIONS, EGRAPH_DEFAULT_NODES};
+    if (limits == NULL)
+        limits = &default_limits;
+
+    egraph_stats result = {};
+    result.cost_before  = evaluation_cost(tree -> root);
+    result.cost_after   = result.cost_before;
+
+    egraph graph = {};
+    graph.error = TREE_ERROR_NO;
+
+    size_t root = add_subtree(&graph, tree -> root);
+    graph.max_nodes = limits -> max_nodes;
+
+    while (graph.error == TREE_ERROR_NO && result.iterations < limits -> max_iterations && !graph.limit_reached)
+    {
+        if (!egraph_take_snapshot(&graph))
+            break;
+
+        graph.changes = 0;
+        for (size_t i = 0; i < graph.snapshot_size && !graph.limit_reached; i++)
+            apply_rules(&graph, i);
+
+        egraph_rebuild(&graph);
+        result.iterations++;
+
+        if (graph.changes == 0)
+        {
+            result.saturated = true;
+            break;
+        }
+    }
+
+    tree_error_type error = graph.error;
+
+    if (error == TREE_ERROR_NO && root != EGRAPH_NONE && egraph_take_snapshot(&graph) && egraph_compute_costs(&graph))
+    {
+        double cost = graph.costs[egraph_find(&graph, root)];
+
+        if (cost < result.cost_before)
+        {
+            node_t* simplified = egraph_build_tree(&graph, root);
+            if (simplified != NULL)
+            {
+                free_subtree(tree -> root);
+                tree -> root      = simplified;
+                tree -> size      = count_tree_nodes(simplified);
+                result.cost_after = cost;
+            }
+            else
+                error = TREE_ERROR_ALLOCATION;
+        }
+    }
+    else if (error == TREE_ERROR_NO)
+        error = (graph.error != TREE_ERROR_NO) ? graph.error : TREE_ERROR_ALLOCATION;
+
+    result.nodes = graph.size;
+    for (size_t i = 0; i < graph.size; i++)
+        result.classes += (graph.parent[i] == i);
+
+    if (stats != NULL)
+        *stats = result;
+
+    egraph_destroy(&graph);
+
+    return error;
+}
@@ -0,0 +1,39 @@
+#ifndef EGRAPH_H_
+#define EGRAPH_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "tree_common.h"
+#include "tree_error_types.h"
+
+// Упрощение насыщением e-графа. Классы равных подвыражений пополняются алгебраическими
+// правилами (коммутативность, ассоциативность, раскрытие скобок и вынесение общего множителя,
+// приведение к общему знаменателю, степени, свёртка чисел), пока правила дают новое
+// или не исчерпаны пределы. Затем из графа извлекается самое дешёвое по evaluation_cost дерево;
+// исходное дерево заменяется, только если новое дешевле.
+// Правила сохраняют значение везде, где исходное выражение определено,
+// кроме a*0 = 0 и a-a = 0, которые уже применяет optimize_tree_with_dump
+struct egraph_limits
+{
+    size_t max_iterations;
+    size_t max_nodes;
+};
+
+struct egraph_stats
+{
+    size_t iterations;
+    size_t nodes;
+    size_t classes;
+    double cost_before;
+    double cost_after;
+    bool   saturated;   // правила перестали что-либо менять раньше пределов
+};
+
+const size_t EGRAPH_DEFAULT_ITERATIONS = 8;
+const size_t EGRAPH_DEFAULT_NODES      = 20000;
+
+double          evaluation_cost          (const node_t* node);
+tree_error_type simplify_tree_with_egraph(tree_t* tree, const egraph_limits* limits, egraph_stats* stats);
+
+#endif // EGRAPH_H_
@@ -0,0 +1,406 @@
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FAST_MATH_HAS_X86_KERNELS 1
+#else
+#define FAST_MATH_HAS_X86_KERNELS 0
+#endif
+
+#include "fast_math.h"
+
+typedef void (*unary_kernel)(const double* argument, double* out, size_t count);
+
+struct fast_math_kernels
+{
+    const char*  name;
+    unary_kernel sin;
+    unary_kernel cos;
+    unary_kernel exp;
+    unary_kernel ln;
+};
+
+// ==================== КОНСТАНТЫ ====================
+
+// 1.5 * 2^52: x + ROUNDING_SHIFT - ROUNDING_SHIFT округляет x к целому,
+// а младшие биты мантиссы суммы содержат это целое в дополнительном коде
+const double   ROUNDING_SHIFT      = 0x1.8p52;
+const uint64_t ROUNDING_SHIFT_BITS = 0x4338000000000000ull;
+
+const double LOG2E  = 1.44269504088896338700e+00;
+const double LN2_HI = 6.93147180369123816490e-01;  // 32 старших бита ln2: k * LN2_HI точно
+const double LN2_LO = 1.90821492927058770002e-10;
+const double SQRT2  = 1.41421356237309514547e+00;
+
+const double TWO_OVER_PI = 6.36619772367581382433e-01;
+const double PIO2_1      = 1.57079632673412561417e+00;  // pi/2 тремя частями по 33 бита
+const double PIO2_2      = 6.07710050630396597660e-11;
+const double PIO2_3      = 2.02226624871116645580e-21;
+
+// вне этих областей (и для inf/NaN) вызывается libm
+const double EXP_FAST_LIMIT = 708.0;
+
+const uint64_t MANTISSA_MASK = 0x000fffffffffffffull;
+const uint64_t ONE_BITS      = 0x3ff0000000000000ull;
+const uint64_t SIGN_MASK     = 0x8000000000000000ull;
+
+// 1/13!, ..., 1/2!, 1, 1: exp(r) на |r| <= ln2 / 2
+const double EXP_COEFFICIENTS[] = {
+    1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0,
+    1.0 / 40320.0, 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0
+};
+
+// 1/21, ..., 1/3: ln(m) = 2s + 2s * z * P(z), s = (m - 1) / (m + 1), z = s^2
+const double LN_COEFFICIENTS[] = {
+    1.0 / 21.0, 1.0 / 19.0, 1.0 / 17.0, 1.0 / 15.0, 1.0 / 13.0,
+    1.0 / 11.0, 1.0 / 9.0,  1.0 / 7.0,  1.0 / 5.0,  1.0 / 3.0
+};
+
+// sin(r) = r + r * z * S(z), cos(r) = 1 - z / 2 + z^2 * C(z) на |r| <= pi/4
+const double SIN_COEFFICIENTS[] = {
+    -1.0 / 1307674368000.0, 1.0 / 6227020800.0, -1.0 / 39916800.0, 1.0 / 362880.0,
+    -1.0 / 5040.0, 1.0 / 120.0, -1.0 / 6.0
+};
+
+const double COS_COEFFICIENTS[] = {
+    1.0 / 20922789888000.0, -1.0 / 87178291200.0, 1.0 / 479001600.0, -1.0 / 3628800.0,
+    1.0 / 40320.0, -1.0 / 720.0, 1.0 / 24.0
+};
+
+const size_t EXP_DEGREE = sizeof(EXP_COEFFICIENTS) / sizeof(EXP_COEFFICIENTS[0]);
+const size_t LN_DEGREE  = sizeof(LN_COEFFICIENTS)  / sizeof(LN_COEFFICIENTS[0]);
+const size_t SIN_DEGREE = sizeof(SIN_COEFFICIENTS) / sizeof(SIN_COEFFICIENTS[0]);
+const size_t COS_DEGREE = sizeof(COS_COEFFICIENTS) / sizeof(COS_COEFFICIENTS[0]);
+
+// ==================== СКАЛЯРНЫЕ ЯДРА ====================
+
+static double bits_to_double(uint64_t bits)
+{
+    double number = 0.0;
+    memcpy(&number, &bits, sizeof(number));
+
+    return number;
+}
+
+
+static uint64_t double_to_bits(double number)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, &number, sizeof(bits));
+
+    return bits;
+}
+
+
+static double evaluate_polynomial(const double* coefficients, size_t degree, double argument)
+{
+    double result = coefficients[0];
+    for (size_t i = 1; i < degree; i++)
+        result = result * argument + coefficients[i];
+
+    return result;
+}
+
+
+static bool is_trig_fast(double argument)
+{
+    return fabs(argument) <= FAST_TRIG_LIMIT;
+}
+
+
+static bool is_exp_fast(double argument)
+{
+    return fabs(argument) <= EXP_FAST_LIMIT;
+}
+
+
+static bool is_ln_fast(double argument)
+{
+    return argument >= DBL_MIN && argument <= DBL_MAX;
+}
+
+
+// quadrant_offset = 0 даёт sin, 1 - cos (cos x = sin(x + pi/2))
+static double fast_sin_quadrant(double argument, uint64_t quadrant_offset)
+{
+    double shifted = argument * TWO_OVER_PI + ROUNDING_SHIFT;
+    double k       = shifted - ROUNDING_SHIFT;
+    uint64_t quadrant = double_to_bits(shifted) + quadrant_offset;
+
+    double r = ((argument - k * PIO2_1) - k * PIO2_2) - k * PIO2_3;
+    double z = r * r;
+
+    double sine   = r + r * z * evaluate_polynomial(SIN_COEFFICIENTS, SIN_DEGREE, z);
+    double cosine = 1.0 - (0.5 * z - z * z * evaluate_polynomial(COS_COEFFICIENTS, COS_DEGREE, z));
+
+    double result = (quadrant & 1) ? cosine : sine;
+
+    return (quadrant & 2) ? -result : result;
+}
+
+
+double fast_sin(double argument)
+{
+    if (!is_trig_fast(argument))
+        return sin(argument);
+
+    return fast_sin_quadrant(argument, 0);
+}
+
+
+double fast_cos(double argument)
+{
+    if (!is_trig_fast(argument))
+        return cos(argument);
+
+    return fast_sin_quadrant(argument, 1);
+}
+
+
+double fast_exp(double argument)
+{
+    if (!is_exp_fast(argument))
+        return exp(argument);
+
+    double shifted = argument * LOG2E + ROUNDING_SHIFT;
+    double k       = shifted - ROUNDING_SHIFT;
+    uint64_t power = double_to_bits(shifted) - ROUNDING_SHIFT_BITS;
+
+    double r = (argument - k * LN2_HI) - k * LN2_LO;
+
+    return evaluate_polynomial(EXP_COEFFICIENTS, EXP_DEGREE, r) * bits_to_double((power + 1023) << 52);
+}
+
+
+double fast_ln(double argument)
+{
+    if (!is_ln_fast(argument))
+        return log(argument);
+
+    uint64_t bits = double_to_bits(argument);
+
+    double exponent = (double)(bits >> 52) - 1023.0;
+    double mantissa = bits_to_double((bits & MANTISSA_MASK) | ONE_BITS);
+
+    if (mantissa > SQRT2)
+    {
+        mantissa *= 0.5;
+        exponent += 1.0;
+    }
+
+    double f = mantissa - 1.0;
+    double s = f / (2.0 + f);
+    double z = s * s;
+
+    double twice_s = 2.0 * s;
+    double ln_mantissa = twice_s + twice_s * z * evaluate_polynomial(LN_COEFFICIENTS, LN_DEGREE, z);
+
+    return exponent * LN2_HI + (ln_mantissa + exponent * LN2_LO);
+}
+
+
+static void scalar_sin_block(const double* argument, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = fast_sin(argument[i]);
+}
+
+
+static void scalar_cos_block(const double* argument, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = fast_cos(argument[i]);
+}
+
+
+static void scalar_exp_block(const double* argument, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = fast_exp(argument[i]);
+}
+
+
+static void scalar_ln_block(const double* argument, double* out, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = fast_ln(argument[i]);
+}
+
+// ==================== AVX2 + FMA ЯДРА ====================
+
+// Векторная часть считает все точки без ветвлений; точки вне быстрой области
+// и хвост блока потом пересчитываются скалярными функциями
+
+#if FAST_MATH_HAS_X86_KERNELS
+
+#define FAST_MATH_TARGET __attribute__((target("avx2,fma")))
+
+FAST_MATH_TARGET
+static __m256d avx2_polynomial(const double* coefficients, size_t degree, __m256d argument)
+{
+    __m256d result = _mm256_set1_pd(coefficients[0]);
+    for (size_t i = 1; i < degree; i++)
+        result = _mm256_fmadd_pd(result, argument, _mm256_set1_pd(coefficients[i]));
+
+    return result;
+}
+
+
+FAST_MATH_TARGET
+static __m256d avx2_sin_quadrant(__m256d argument, uint64_t quadrant_offset)
+{
+    __m256d shifted = _mm256_fmadd_pd(argument, _mm256_set1_pd(TWO_OVER_PI), _mm256_set1_pd(ROUNDING_SHIFT));
+    __m256d k       = _mm256_sub_pd(shifted, _mm256_set1_pd(ROUNDING_SHIFT));
+    __m256i quadrant = _mm256_add_epi64(_mm256_castpd_si256(shifted), _mm256_set1_epi64x((long long)quadrant_offset));
+
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(PIO2_1), argument);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(PIO2_2), r);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(PIO2_3), r);
+    __m256d z = _mm256_mul_pd(r, r);
+
+    __m256d sine   = _mm256_fmadd_pd(_mm256_mul_pd(r, z), avx2_polynomial(SIN_COEFFICIENTS, SIN_DEGREE, z), r);
+    __m256d cosine = _mm256_sub_pd(_mm256_set1_pd(1.0),
+                                   _mm256_fmsub_pd(_mm256_set1_pd(0.5), z,
+                                                   _mm256_mul_pd(_mm256_mul_pd(z, z),
+                                                                 avx2_polynomial(COS_COEFFICIENTS, COS_DEGREE, z))));
+
+    __m256i one = _mm256_set1_epi64x(1);
+    __m256i use_cosine = _mm256_cmpeq_epi64(_mm256_and_si256(quadrant, one), one);
+    __m256d result = _mm256_blendv_pd(sine, cosine, _mm256_castsi256_pd(use_cosine));
+
+    __m256i sign = _mm256_slli_epi64(_mm256_srli_epi64(quadrant, 1), 63);
+
+    return _mm256_xor_pd(result, _mm256_castsi256_pd(sign));
+}
+
+
+FAST_MATH_TARGET
+static __m256d avx2_exp(__m256d argument)
+{
+    __m256d shifted = _mm256_fmadd_pd(argument, _mm256_set1_pd(LOG2E), _mm256_set1_pd(ROUNDING_SHIFT));
+    __m256d k       = _mm256_sub_pd(shifted, _mm256_set1_pd(ROUNDING_SHIFT));
+    __m256i power   = _mm256_sub_epi64(_mm256_castpd_si256(shifted), _mm256_set1_epi64x((long long)ROUNDING_SHIFT_BITS));
+
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(LN2_HI), argument);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(LN2_LO), r);
+
+    __m256i scale = _mm256_slli_epi64(_mm256_add_epi64(power, _mm256_set1_epi64x(1023)), 52);
+
+    return _mm256_mul_pd(avx2_polynomial(EXP_COEFFICIENTS, EXP_DEGREE, r), _mm256_castsi256_pd(scale));
+}
+
+
+FAST_MATH_TARGET
+static __m256d avx2_ln(__m256d argument)
+{
+    __m256i bits = _mm256_castpd_si256(argument);
+
+    // показатель в double через 2^52 + e: в AVX2 нет преобразования int64 -> double
+    __m256i exponent_bits = _mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x4330000000000000ll));
+    __m256d exponent = _mm256_sub_pd(_mm256_castsi256_pd(exponent_bits), _mm256_set1_pd(0x1p52 + 1023.0));
+
+    __m256d mantissa = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x((long long)MANTISSA_MASK)),
+                                                           _mm256_set1_epi64x((long long)ONE_BITS)));
+
+    __m256d is_large = _mm256_cmp_pd(mantissa, _mm256_set1_pd(SQRT2), _CMP_GT_OQ);
+    mantissa = _mm256_blendv_pd(mantissa, _mm256_mul_pd(mantissa, _mm256_set1_pd(0.5)), is_large);
+    exponent = _mm256_add_pd(exponent, _mm256_and_pd(is_large, _mm256_set1_pd(1.0)));
+
+    __m256d f = _mm256_sub_pd(mantissa, _mm256_set1_pd(1.0));
+    __m256d s = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2.0), f));
+    __m256d z = _mm256_mul_pd(s, s);
+
+    __m256d twice_s = _mm256_add_pd(s, s);
+    __m256d ln_mantissa = _mm256_fmadd_pd(_mm256_mul_pd(twice_s, z), avx2_polynomial(LN_COEFFICIENTS, LN_DEGREE, z), twice_s);
+
+    return _mm256_fmadd_pd(exponent, _mm256_set1_pd(LN2_HI), _mm256_fmadd_pd(exponent, _mm256_set1_pd(LN2_LO), ln_mantissa));
+}
+
+
+#define DEFINE_AVX2_BLOCK(name, vector_expression, scalar_function, is_fast)        \
+    FAST_MATH_TARGET                                                                 \
+    static void name(const double* argument, double* out, size_t count)             \
+    {                                                                                \
+        size_t i = 0;                                                                \
+        for (; i + 4 <= count; i += 4)                                               \
+        {                                                                            \
+            __m256d x = _mm256_loadu_pd(argument + i);                               \
+            _mm256_storeu_pd(out + i, vector_expression);                            \
+        }                                                                            \
+        for (size_t j = 0; j < i; j++)                                               \
+            if (!is_fast(argument[j]))                                               \
+                out[j] = scalar_function(argument[j]);                               \
+        for (; i < count; i++)                                                       \
+            out[i] = scalar_function(argument[i]);                                   \
+    }
+
+DEFINE_AVX2_BLOCK(avx2_sin_block, avx2_sin_quadrant(x, 0), fast_sin, is_trig_fast)
+DEFINE_AVX2_BLOCK(avx2_cos_block, avx2_sin_quadrant(x, 1), fast_cos, is_trig_fast)
+DEFINE_AVX2_BLOCK(avx2_exp_block, avx2_exp(x),             fast_exp, is_exp_fast)
+DEFINE_AVX2_BLOCK(avx2_ln_block,  avx2_ln(x),              fast_ln,  is_ln_fast)
+
+#undef DEFINE_AVX2_BLOCK
+#undef FAST_MATH_TARGET
+
+#endif // FAST_MATH_HAS_X86_KERNELS
+
+
+static const fast_math_kernels* select_fast_math_kernels()
+{
+    static const fast_math_kernels scalar_kernels = {"scalar", scalar_sin_block, scalar_cos_block,
+                                                     scalar_exp_block, scalar_ln_block};
+
+#if FAST_MATH_HAS_X86_KERNELS
+    static const fast_math_kernels avx2_kernels   = {"avx2+fma", avx2_sin_block, avx2_cos_block,
+                                                     avx2_exp_block, avx2_ln_block};
+
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return &avx2_kernels;
+#endif
+
+    return &scalar_kernels;
+}
+
+
+static const fast_math_kernels* get_fast_math_kernels()
+{
+    static const fast_math_kernels* selected = select_fast_math_kernels();
+
+    return selected;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+void fast_sin_block(const double* argument, double* out, size_t count)
+{
+    get_fast_math_kernels() -> sin(argument, out, count);
+}
+
+
+void fast_cos_block(const double* argument, double* out, size_t count)
+{
+    get_fast_math_kernels() -> cos(argument, out, count);
+}
+
+
+void fast_exp_block(const double* argument, double* out, size_t count)
+{
+    get_fast_math_kernels() -> exp(argument, out, count);
+}
+
+
+void fast_ln_block(const double* argument, double* out, size_t count)
+{
+    get_fast_math_kernels() -> ln(argument, out, count);
+}
+
+
+const char* fast_math_kernels_name()
+{
+    return get_fast_math_kernels() -> name;
+}
@@ -0,0 +1,27 @@
+#ifndef FAST_MATH_H_
+#define FAST_MATH_H_
+
+#include <stddef.h>
+
+// Приближённые sin/cos/exp/ln для режима BATCH_MATH_FAST.
+// Максимальная ошибка относительно libm, измерена на 2 * 10^7 случайных точек
+// (скалярные и AVX2-ядра дают одинаковые границы, benchmark проверяет их на 10^6 точек):
+//   fast_exp            - 1 ulp при |x| <= 708
+//   fast_ln             - 2 ulp при 0.5 <= x <= 2, 1 ulp для остальных x из [1e-300, 1e300]
+//   fast_sin, fast_cos  - 1 ulp при |x| <= 100, 2 ulp при |x| <= FAST_TRIG_LIMIT
+// Вне этих областей, для inf и NaN вызывается libm. AVX2-ядра используют FMA,
+// поэтому их результат может отличаться от скалярных функций в последнем бите
+const double FAST_TRIG_LIMIT = 1e5;
+
+double      fast_sin(double argument);
+double      fast_cos(double argument);
+double      fast_exp(double argument);
+double      fast_ln (double argument);
+
+void        fast_sin_block(const double* argument, double* out, size_t count);
+void        fast_cos_block(const double* argument, double* out, size_t count);
+void        fast_exp_block(const double* argument, double* out, size_t count);
+void        fast_ln_block (const double* argument, double* out, size_t count);
+const char* fast_math_kernels_name();
+
+#endif // FAST_MATH_H_
@@ -0,0 +1,134 @@
+#include <math.h>
+#include <string.h>
+
+#include "forward_ad.h"
+#include "typed_eval.h"
+#include "logic_functions.h"
+#include "power_reduction.h"
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static tree_error_type apply_dual_operation(node_t* node, dual_number left, dual_number right, dual_number* result)
+{
+    switch (node -> data.op_value)
+    {
+        case OP_ADD:
+            *result = left + right;
+            break;
+        case OP_SUB:
+            *result = left - right;
+            break;
+        case OP_MUL:
+            *result = left * right;
+            break;
+        case OP_DIV:
+            if (is_zero(right.value))
+                return TREE_ERROR_DIVISION_BY_ZERO;
+            *result = left / right;
+            break;
+        case OP_SIN:
+            *result = dual_sin(right);
+            break;
+        case OP_COS:
+            *result = dual_cos(right);
+            break;
+        case OP_POW:
+            if (node -> right -> type == NODE_NUM && is_reducible_exponent(node -> right -> data.num_value))
+                *result = reduced_pow_as(left, node -> right -> data.num_value);
+            else
+                *result = dual_pow(left, right);
+            break;
+        case OP_LN:
+            if (right.value <= 0)
+                return TREE_ERROR_YCHI_MATAN;
+            *result = dual_ln(right);
+            break;
+        case OP_EXP:
+            *result = dual_exp(right);
+            break;
+        default:
+            return TREE_ERROR_UNKNOWN_OPERATION;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type evaluate_tree_dual(node_t* node, variable_table* var_table,
+                                   const char* variable_name, dual_number* result)
+{
+    if (node == NULL || var_table == NULL || variable_name == NULL || result == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    switch (node -> type)
+    {
+        case NODE_NUM:
+            *result = make_dual(node -> data.num_value, 0.0);
+            return TREE_ERROR_NO;
+
+        case NODE_VAR:
+            {
+                if (node -> data.var_definition.name == NULL)
+                    return TREE_ERROR_VARIABLE_NOT_FOUND;
+
+                double value = 0.0;
+                tree_error_type error = get_variable_value(var_table, node -> data.var_definition.name, &value);
+                if (error != TREE_ERROR_NO)
+                    return error;
+
+                double seed = (strcmp(node -> data.var_definition.name, variable_name) == 0) ? 1.0 : 0.0;
+                *result = make_dual(value, seed);
+
+                return TREE_ERROR_NO;
+            }
+
+        case NODE_OP:
+            {
+                dual_number left  = make_dual(0.0, 0.0);
+                dual_number right = make_dual(0.0, 0.0);
+                tree_error_type error = TREE_ERROR_NO;
+
+                if (node -> right == NULL)
+                    return TREE_ERROR_NULL_PTR;
+
+                if (!is_unary(node -> data.op_value))
+                {
+                    if (node -> left == NULL)
+                        return TREE_ERROR_NULL_PTR;
+
+                    error = evaluate_tree_dual(node -> left, var_table, variable_name, &left);
+                    if (error != TREE_ERROR_NO)
+                        return error;
+                }
+
+                error = evaluate_tree_dual(node -> right, var_table, variable_name, &right);
+                if (error != TREE_ERROR_NO)
+                    return error;
+
+                return apply_dual_operation(node, left, right, result);
+            }
+
+        default:
+            return TREE_ERROR_UNKNOWN_OPERATION;
+    }
+}
+
+
+tree_error_type evaluate_tree_with_derivative(tree_t* tree, variable_table* var_table, const char* variable_name,
+                                              double* value, double* derivative)
+{
+    if (tree == NULL || var_table == NULL || variable_name == NULL || value == NULL || derivative == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    dual_number result = make_dual(0.0, 0.0);
+
+    tree_error_type error = evaluate_tree_dual(tree -> root, var_table, variable_name, &result);
+    if (error != TREE_ERROR_NO)
+        return error;
+
+    *value      = result.value;
+    *derivative = result.derivative;
+
+    return TREE_ERROR_NO;
+}
@@ -0,0 +1,16 @@
+#ifndef FORWARD_AD_H_
+#define FORWARD_AD_H_
+
+#include "tree_common.h"
+#include "dual_number.h"
+#include "variable_parse.h"
+#include "tree_error_types.h"
+
+// Прямой режим: один обход дерева на дуальных числах даёт f и df/d(variable_name)
+// в точке из variable_table без построения дерева производной и без выделения памяти
+tree_error_type evaluate_tree_dual           (node_t* node, variable_table* var_table,
+                                              const char* variable_name, dual_number* result);
+tree_error_type evaluate_tree_with_derivative(tree_t* tree, variable_table* var_table, const char* variable_name,
+                                              double* value, double* derivative);
+
+#endif // FORWARD_AD_H_
@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include "incremental_eval.h"
+
+static_assert(MAX_NUMBER_OF_VARIABLES <= 64, "variable_mask holds one bit per variable");
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static tree_error_type recompute_all(incremental_evaluator* evaluator)
+{
+    double unused_result = 0.0;
+    evaluator -> executed = evaluator -> expr -> size;
+
+    return evaluate_compiled(evaluator -> expr, evaluator -> values, evaluator -> slots, &unused_result);
+}
+
+
+static tree_error_type recompute_dependents(incremental_evaluator* evaluator, int variable)
+{
+    size_t begin = evaluator -> dependents_start[variable];
+    size_t end   = evaluator -> dependents_start[variable + 1];
+
+    evaluator -> executed = end - begin;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        tree_error_type error = execute_instruction(evaluator -> expr, evaluator -> dependents[i],
+                                                    evaluator -> values, evaluator -> slots);
+        if (error != TREE_ERROR_NO)
+            return error;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+static tree_error_type recompute_masked(incremental_evaluator* evaluator, variable_mask changed)
+{
+    for (size_t i = 0; i < evaluator -> expr -> size; i++)
+    {
+        if ((evaluator -> dependencies[i] & changed) == 0)
+            continue;
+
+        evaluator -> executed++;
+
+        tree_error_type error = execute_instruction(evaluator -> expr, i, evaluator -> values, evaluator -> slots);
+        if (error != TREE_ERROR_NO)
+            return error;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+static tree_error_type build_dependents_index(incremental_evaluator* evaluator)
+{
+    const compiled_expression* expr = evaluator -> expr;
+    int number_of_variables = expr -> number_of_variables;
+
+    evaluator -> dependents_start = (size_t*)calloc((size_t)number_of_variables + 1, sizeof(size_t));
+    if (evaluator -> dependents_start == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    size_t total = 0;
+    for (int variable = 0; variable < number_of_variables; variable++)
+    {
+        evaluator -> dependents_start[variable] = total;
+
+        for (size_t i = 0; i < expr -> size; i++)
+            if (evaluator -> dependencies[i] & ((variable_mask)1 << variable))
+                total++;
+    }
+    evaluator -> dependents_start[number_of_variables] = total;
+
+    evaluator -> dependents = (size_t*)calloc(total + 1, sizeof(size_t));
+    if (evaluator -> dependents == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    // инструкции идут в топологическом порядке, поэтому группы уже упорядочены
+    size_t position = 0;
+    for (int variable = 0; variable < number_of_variables; variable++)
+        for (size_t i = 0; i < expr -> size; i++)
+            if (evaluator -> dependencies[i] & ((variable_mask)1 << variable))
+                evaluator -> dependents[position++] = i;
+
+    return TREE_ERROR_NO;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type compute_variable_dependencies(const compiled_expression* expr, variable_mask* dependencies)
+{
+    if (expr == NULL || dependencies == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    for (size_t i = 0; i < expr -> size; i++)
+    {
+        const instruction_t* instruction = &expr -> instructions[i];
+        variable_mask mask = 0;
+
+        if (instruction -> code == INSTR_VAR)
+            mask = (variable_mask)1 << instruction -> variable;
+
+        if (instruction -> left  != NO_OPERAND)
+            mask |= dependencies[instruction -> left];
+        if (instruction -> right != NO_OPERAND)
+            mask |= dependencies[instruction -> right];
+
+        dependencies[i] = mask;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+tree_error_type incremental_evaluator_create(incremental_evaluator* evaluator, const compiled_expression* expr)
+{
+    if (evaluator == NULL || expr == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    size_t number_of_variables = (size_t)expr -> number_of_variables;
+
+    evaluator -> expr             = expr;
+    evaluator -> executed         = 0;
+    evaluator -> is_valid         = false;
+    evaluator -> dependents       = NULL;
+    evaluator -> dependents_start = NULL;
+    evaluator -> slots            = (double*)       calloc(expr -> size + 1,       sizeof(double));
+    evaluator -> dependencies     = (variable_mask*)calloc(expr -> size + 1,       sizeof(variable_mask));
+    evaluator -> seen_versions    = (size_t*)       calloc(number_of_variables + 1, sizeof(size_t));
+    evaluator -> values           = (double*)       calloc(number_of_variables + 1, sizeof(double));
+
+    if (evaluator -> slots == NULL || evaluator -> dependencies == NULL ||
+        evaluator -> seen_versions == NULL || evaluator -> values == NULL)
+    {
+        incremental_evaluator_destroy(evaluator);
+        return TREE_ERROR_ALLOCATION;
+    }
+
+    compute_variable_dependencies(expr, evaluator -> dependencies);
+
+    tree_error_type error = build_dependents_index(evaluator);
+    if (error != TREE_ERROR_NO)
+        incremental_evaluator_destroy(evaluator);
+
+    return error;
+}
+
+
+tree_error_type incremental_evaluator_destroy(incremental_evaluator* evaluator)
+{
+    if (evaluator == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    free(evaluator -> slots);
+    free(evaluator -> dependencies);
+    free(evaluator -> dependents);
+    free(evaluator -> dependents_start);
+    free(evaluator -> seen_versions);
+    free(evaluator -> values);
+
+    evaluator -> slots            = NULL;
+    evaluator -> dependencies     = NULL;
+    evaluator -> dependents       = NULL;
+    evaluator -> dependents_start = NULL;
+    evaluator -> seen_versions    = NULL;
+    evaluator -> values           = NULL;
+    evaluator -> is_valid         = false;
+
+    return TREE_ERROR_NO;
+}
+
+
+tree_error_type incremental_evaluate(incremental_evaluator* evaluator, variable_table* var_table, double* result)
+{
+    if (evaluator == NULL || var_table == NULL || result == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    const compiled_expression* expr = evaluator -> expr;
+    if (expr -> result == NO_OPERAND)
+        return TREE_ERROR_NULL_PTR;
+
+    if (var_table -> number_of_variables < expr -> number_of_variables)
+        return TREE_ERROR_VARIABLE_TABLE;
+
+    variable_mask changed = 0;
+    int changed_variable  = 0;
+
+    for (int i = 0; i < expr -> number_of_variables; i++)
+    {
+        const variable_t* variable = &var_table -> variables[i];
+        if (!variable -> is_defined)
+            return TREE_ERROR_VARIABLE_UNDEFINED;
+
+        evaluator -> values[i] = variable -> value;
+
+        if (variable -> version != evaluator -> seen_versions[i])
+        {
+            changed |= (variable_mask)1 << i;
+            changed_variable = i;
+        }
+    }
+
+    tree_error_type error = TREE_ERROR_NO;
+    evaluator -> executed = 0;
+
+    if (!evaluator -> is_valid)
+        error = recompute_all(evaluator);
+    else if (changed == 0)
+        error = TREE_ERROR_NO;
+    else if ((changed & (changed - 1)) == 0)
+        error = recompute_dependents(evaluator, changed_variable);
+    else
+        error = recompute_masked(evaluator, changed);
+
+    if (error != TREE_ERROR_NO)
+    {
+        evaluator -> is_valid = false;
+        return error;
+    }
+
+    for (int i = 0; i < expr -> number_of_variables; i++)
+        evaluator -> seen_versions[i] = var_table -> variables[i].version;
+
+    evaluator -> is_valid = true;
+    *result = evaluator -> slots[expr -> result];
+
+    return TREE_ERROR_NO;
+}
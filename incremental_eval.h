@@ -0,0 +1,33 @@
+#ifndef INCREMENTAL_EVAL_H_
+#define INCREMENTAL_EVAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "variable_parse.h"
+#include "tree_error_types.h"
+#include "compiled_expression.h"
+
+typedef uint64_t variable_mask;
+
+// Кэширует значения всех узлов. После set_variable_value пересчитываются
+// только узлы, зависящие от изменившихся переменных (по version в variable_t)
+struct incremental_evaluator
+{
+    const compiled_expression* expr;
+    double*                    slots;
+    variable_mask*             dependencies;      // маска переменных для каждой инструкции
+    size_t*                    dependents;        // номера зависимых инструкций, сгруппированные по переменным
+    size_t*                    dependents_start;  // начало группы переменной в dependents
+    size_t*                    seen_versions;
+    double*                    values;
+    size_t                     executed;          // инструкций выполнил последний incremental_evaluate
+    bool                       is_valid;
+};
+
+tree_error_type incremental_evaluator_create   (incremental_evaluator* evaluator, const compiled_expression* expr);
+tree_error_type incremental_evaluator_destroy  (incremental_evaluator* evaluator);
+tree_error_type incremental_evaluate           (incremental_evaluator* evaluator, variable_table* var_table, double* result);
+tree_error_type compute_variable_dependencies  (const compiled_expression* expr, variable_mask* dependencies);
+
+#endif // INCREMENTAL_EVAL_H_
@@ -0,0 +1,385 @@
+#include <stdio.h>
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "jit_codegen.h"
+#include "logic_functions.h"
+
+// ==================== ГЕНЕРАЦИЯ C-КОДА ====================
+
+static const char* binary_instruction_operator(instruction_code code)
+{
+    switch (code)
+    {
+        case INSTR_ADD: return "+";
+        case INSTR_SUB: return "-";
+        case INSTR_MUL: return "*";
+        case INSTR_DIV: return "/";
+        case INSTR_NUM:
+        case INSTR_VAR:
+        case INSTR_SIN:
+        case INSTR_COS:
+        case INSTR_POW:
+        case INSTR_LN:
+        case INSTR_EXP:
+        case INSTR_POWI:
+        default:        return NULL;
+    }
+}
+
+
+static const char* unary_instruction_function(instruction_code code)
+{
+    switch (code)
+    {
+        case INSTR_SIN: return "sin";
+        case INSTR_COS: return "cos";
+        case INSTR_LN:  return "log";
+        case INSTR_EXP: return "exp";
+        case INSTR_NUM:
+        case INSTR_VAR:
+        case INSTR_ADD:
+        case INSTR_SUB:
+        case INSTR_MUL:
+        case INSTR_DIV:
+        case INSTR_POW:
+        case INSTR_POWI:
+        default:        return NULL;
+    }
+}
+
+
+// Проверки области определения ставятся перед инструкцией, как в execute_instruction
+static tree_error_type write_instruction(FILE* file, const instruction_t* instruction, size_t slot)
+{
+    if (instruction -> code == INSTR_DIV)
+        fprintf(file, "    if (fabs(s%d) < %a) return %d;\n", instruction -> right, ZERO_EPSILON,
+                (int)TREE_ERROR_DIVISION_BY_ZERO);
+
+    if (instruction -> code == INSTR_LN)
+        fprintf(file, "    if (!(s%d > 0)) return %d;\n", instruction -> right, (int)TREE_ERROR_YCHI_MATAN);
+
+    fprintf(file, "    const double s%zu = ", slot);
+
+    switch (instruction -> code)
+    {
+        case INSTR_NUM:
+            fprintf(file, "%a;\n", instruction -> value);
+            return TREE_ERROR_NO;
+
+        case INSTR_VAR:
+            fprintf(file, "vars[%d];\n", instruction -> variable);
+            return TREE_ERROR_NO;
+
+        case INSTR_ADD:
+        case INSTR_SUB:
+        case INSTR_MUL:
+        case INSTR_DIV:
+            fprintf(file, "s%d %s s%d;\n", instruction -> left,
+                    binary_instruction_operator(instruction -> code), instruction -> right);
+            return TREE_ERROR_NO;
+
+        case INSTR_SIN:
+        case INSTR_COS:
+        case INSTR_LN:
+        case INSTR_EXP:
+            fprintf(file, "%s(s%d);\n", unary_instruction_function(instruction -> code), instruction -> right);
+            return TREE_ERROR_NO;
+
+        case INSTR_POW:
+            fprintf(file, "pow(s%d, s%d);\n", instruction -> left, instruction -> right);
+            return TREE_ERROR_NO;
+
+        case INSTR_POWI:
+            fprintf(file, "jit_reduced_pow(s%d, %a);\n", instruction -> left, instruction -> value);
+            return TREE_ERROR_NO;
+
+        default:
+            return TREE_ERROR_UNKNOWN_OPERATION;
+    }
+}
+
+
+tree_error_type write_c_source(const compiled_expression* expr, FILE* file)
+{
+    if (expr == NULL || file == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (expr -> result == NO_OPERAND)
+        return TREE_ERROR_NULL_PTR;
+
+    int vector_size = (expr -> number_of_variables > 0) ? expr -> number_of_variables : 1;
+
+    fprintf(file, "#include <math.h>\n");
+    fprintf(file, "#include <stddef.h>\n\n");
+
+    // копия reduced_pow: показатель - константа, поэтому компилятор разворачивает цикл
+    fprintf(file, "static inline double jit_reduced_pow(double base, double exponent)\n{\n");
+    fprintf(file, "    double magnitude = fabs(exponent), whole = floor(magnitude);\n");
+    fprintf(file, "    double result = 1.0, square = base;\n");
+    fprintf(file, "    for (unsigned power = (unsigned)whole; power != 0; )\n    {\n");
+    fprintf(file, "        if (power & 1u) result *= square;\n");
+    fprintf(file, "        power >>= 1;\n");
+    fprintf(file, "        if (power != 0) square *= square;\n    }\n");
+    fprintf(file, "    if (magnitude > whole) result *= sqrt(base);\n");
+    fprintf(file, "    return (exponent < 0) ? 1.0 / result : result;\n}\n\n");
+
+    fprintf(file, "static inline int jit_body(const double* vars, double* result)\n{\n");
+    fprintf(file, "    (void)vars;\n");
+    for (size_t i = 0; i < expr -> size; i++)
+    {
+        tree_error_type error = write_instruction(file, &expr -> instructions[i], i);
+        if (error != TREE_ERROR_NO)
+            return error;
+    }
+    fprintf(file, "    *result = s%d;\n", expr -> result);
+    fprintf(file, "    return 0;\n}\n\n");
+
+    fprintf(file, "int jit_scalar(const double* vars, double* result)\n{\n");
+    fprintf(file, "    return jit_body(vars, result);\n}\n\n");
+
+    fprintf(file, "int jit_batch(const double* const* vars, size_t count, double* results)\n{\n");
+    fprintf(file, "    for (size_t point = 0; point < count; point++)\n    {\n");
+    fprintf(file, "        double values[%d] = {0};\n", vector_size);
+    fprintf(file, "        for (int i = 0; i < %d; i++)\n", expr -> number_of_variables);
+    fprintf(file, "            values[i] = vars[i][point];\n");
+    fprintf(file, "        int error = jit_body(values, &results[point]);\n");
+    fprintf(file, "        if (error != 0) return error;\n");
+    fprintf(file, "    }\n    return 0;\n}\n");
+
+    return ferror(file) ? TREE_ERROR_IO : TREE_ERROR_NO;
+}
+
+// ==================== КЭШ И ЗАГРУЗКА ====================
+
+// Исходный текст программы целиком; освобождается вызывающим
+static char* generate_source(const compiled_expression* expr)
+{
+    char*  source = NULL;
+    size_t length = 0;
+
+    FILE* stream = open_memstream(&source, &length);
+    if (stream == NULL)
+        return NULL;
+
+    tree_error_type error = write_c_source(expr, stream);
+    fclose(stream);
+
+    if (error != TREE_ERROR_NO)
+    {
+        free(source);
+        return NULL;
+    }
+
+    return source;
+}
+
+
+// Текст программы вшивается в библиотеку строкой jit_source для проверки при загрузке
+static void write_source_literal(FILE* file, const char* source)
+{
+    fprintf(file, "\nconst char jit_source[] =\n    \"");
+
+    for (const char* c = source; *c != '\0'; c++)
+    {
+        if (*c == '\n')
+            fprintf(file, "\\n\"\n    \"");
+        else if (*c == '\\' || *c == '"')
+            fprintf(file, "\\%c", *c);
+        else
+            fputc(*c, file);
+    }
+
+    fprintf(file, "\";\n");
+}
+
+
+static bool load_library(jit_expression* jit, const char* library_path, const char* source)
+{
+    void* library = dlopen(library_path, RTLD_NOW | RTLD_LOCAL);
+    if (library == NULL)
+        return false;
+
+    void* scalar_symbol = dlsym(library, "jit_scalar");
+    void* batch_symbol  = dlsym(library, "jit_batch");
+    const char* embedded_source = (const char*)dlsym(library, "jit_source");
+
+    // коллизия хэша или устаревший файл в кэше
+    if (scalar_symbol == NULL || batch_symbol == NULL || embedded_source == NULL ||
+        strcmp(embedded_source, source) != 0)
+    {
+        dlclose(library);
+        return false;
+    }
+
+    // преобразование void* в указатель на функцию условно поддерживается стандартом,
+    // поэтому адрес копируется побайтно
+    jit_scalar_function scalar = NULL;
+    jit_batch_function  batch  = NULL;
+    memcpy(&scalar, &scalar_symbol, sizeof(scalar));
+    memcpy(&batch,  &batch_symbol,  sizeof(batch));
+
+    jit -> library = library;
+    jit -> scalar  = scalar;
+    jit -> batch   = batch;
+
+    return true;
+}
+
+
+static bool build_library(const char* source_text, const char* source_path, const char* library_path)
+{
+    char command[MAX_LENGTH_OF_SYSTEM_COMMAND] = {};
+
+    snprintf(command, sizeof(command), "mkdir -p %s", JIT_CACHE_FOLDER_NAME);
+    if (system(command) != 0)
+        return false;
+
+    FILE* source = fopen(source_path, "w");
+    if (source == NULL)
+        return false;
+
+    fputs(source_text, source);
+    write_source_literal(source, source_text);
+
+    bool written = !ferror(source);
+    fclose(source);
+
+    if (!written)
+        return false;
+
+    const char* compiler = getenv("CC");
+    if (compiler == NULL || compiler[0] == '\0')
+        compiler = JIT_DEFAULT_COMPILER;
+
+    char temporary_path[MAX_LENGTH_OF_FILENAME] = {};
+    snprintf(temporary_path, sizeof(temporary_path), "%s.%d.tmp", library_path, getpid());
+
+    snprintf(command, sizeof(command), "%s -O2 -ffp-contract=off -shared -fPIC -o \"%s\" \"%s\" -lm > /dev/null 2>&1",
+             compiler, temporary_path, source_path);
+
+    if (system(command) != 0)
+    {
+        remove(temporary_path);
+        return false;
+    }
+
+    // rename атомарен, поэтому параллельные процессы не увидят недописанный файл
+    return rename(temporary_path, library_path) == 0;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type jit_constructor(jit_expression* jit)
+{
+    if (jit == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    jit -> library = NULL;
+    jit -> scalar  = NULL;
+    jit -> batch   = NULL;
+    jit -> slots   = NULL;
+    jit -> hash    = 0;
+
+    return compiled_expression_constructor(&jit -> fallback);
+}
+
+
+tree_error_type jit_destructor(jit_expression* jit)
+{
+    if (jit == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (jit -> library != NULL)
+        dlclose(jit -> library);
+
+    free(jit -> slots);
+    compiled_expression_destructor(&jit -> fallback);
+
+    return jit_constructor(jit);
+}
+
+
+tree_error_type jit_compile(tree_t* tree, variable_table* var_table, jit_expression* jit)
+{
+    if (tree == NULL || var_table == NULL || jit == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    jit_destructor(jit);
+
+    tree_error_type error = compile_tree(tree, var_table, &jit -> fallback);
+    if (error != TREE_ERROR_NO)
+        return error;
+
+    jit -> slots = (double*)calloc(jit -> fallback.size, sizeof(double));
+    if (jit -> slots == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    jit -> hash = hash_compiled_expression(&jit -> fallback) * 33 + (size_t)JIT_CODEGEN_VERSION;
+
+    char source_path [MAX_LENGTH_OF_FILENAME] = {};
+    char library_path[MAX_LENGTH_OF_FILENAME] = {};
+    snprintf(source_path,  sizeof(source_path),  "%s/expr_%016zx.c",  JIT_CACHE_FOLDER_NAME, jit -> hash);
+    snprintf(library_path, sizeof(library_path), "%s/expr_%016zx.so", JIT_CACHE_FOLDER_NAME, jit -> hash);
+
+    char* source = generate_source(&jit -> fallback);
+    if (source == NULL)
+        return TREE_ERROR_NO;   // остаётся интерпретатор
+
+    if (access(library_path, R_OK) == 0 && load_library(jit, library_path, source))
+    {
+        free(source);
+        return TREE_ERROR_NO;
+    }
+
+    if (build_library(source, source_path, library_path))
+        load_library(jit, library_path, source);
+
+    free(source);
+    return TREE_ERROR_NO;
+}
+
+
+bool jit_is_native(const jit_expression* jit)
+{
+    return jit != NULL && jit -> library != NULL;
+}
+
+
+tree_error_type jit_evaluate(jit_expression* jit, const double* variables, double* result)
+{
+    if (jit == NULL || result == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (jit -> scalar != NULL)
+        return (tree_error_type)jit -> scalar(variables, result);
+
+    return evaluate_compiled(&jit -> fallback, variables, jit -> slots, result);
+}
+
+
+tree_error_type jit_evaluate_batch(jit_expression* jit, const double* const* variables,
+                                   size_t count, double* results)
+{
+    if (jit == NULL || results == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (jit -> batch != NULL)
+        return (tree_error_type)jit -> batch(variables, count, results);
+
+    for (size_t point = 0; point < count; point++)
+    {
+        double values[MAX_NUMBER_OF_VARIABLES] = {};
+        for (int i = 0; i < jit -> fallback.number_of_variables; i++)
+            values[i] = variables[i][point];
+
+        tree_error_type error = evaluate_compiled(&jit -> fallback, values, jit -> slots, &results[point]);
+        if (error != TREE_ERROR_NO)
+            return error;
+    }
+
+    return TREE_ERROR_NO;
+}
@@ -0,0 +1,45 @@
+#ifndef JIT_CODEGEN_H_
+#define JIT_CODEGEN_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "tree_common.h"
+#include "variable_parse.h"
+#include "tree_error_types.h"
+#include "compiled_expression.h"
+
+const char* const JIT_CACHE_FOLDER_NAME = "jit_cache";
+const char* const JIT_DEFAULT_COMPILER  = "cc";
+const int         JIT_CODEGEN_VERSION   = 3;
+
+// Возвращают tree_error_type: нативный код делает те же проверки, что и интерпретатор
+// (деление на число меньше ZERO_EPSILON, ln от неположительного числа),
+// и собирается с -ffp-contract=off, чтобы результат не зависел от наличия компилятора
+typedef int (*jit_scalar_function)(const double* vars, double* result);
+typedef int (*jit_batch_function) (const double* const* vars, size_t count, double* results);
+
+// Без компилятора вычисление идёт через интерпретатор compiled_expression.
+// Библиотека из кэша загружается, только если вшитый в неё исходный текст
+// совпадает с только что сгенерированным: совпадение хэша ничего не гарантирует.
+// Повторный jit_compile освобождает прежние код и буферы
+struct jit_expression
+{
+    void*               library;
+    jit_scalar_function scalar;
+    jit_batch_function  batch;
+    compiled_expression fallback;
+    double*             slots;
+    size_t              hash;
+};
+
+tree_error_type jit_constructor       (jit_expression* jit);
+tree_error_type jit_destructor        (jit_expression* jit);
+tree_error_type jit_compile           (tree_t* tree, variable_table* var_table, jit_expression* jit);
+tree_error_type jit_evaluate          (jit_expression* jit, const double* variables, double* result);
+tree_error_type jit_evaluate_batch    (jit_expression* jit, const double* const* variables,
+                                       size_t count, double* results);
+tree_error_type write_c_source        (const compiled_expression* expr, FILE* file);
+bool            jit_is_native         (const jit_expression* jit);
+
+#endif // JIT_CODEGEN_H_
@@ -3,6 +3,24 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdarg.h>
+
+// snprintf возвращает длину без учёта обрезки: позиция не должна уходить за конец буфера,
+// иначе следующий вызов получит отрицательный размер
+static void append_to_buffer(char* buffer, int* pos, int buffer_size, const char* format, ...)
+{
+    if (*pos >= buffer_size - 1)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + *pos, (size_t)(buffer_size - *pos), format, args);
+    va_end(args);
+
+    if (written > 0)
+        *pos = (*pos + written < buffer_size - 1) ? *pos + written : buffer_size - 1;
+}
+
 
 void tree_to_string_simple(node_t* node, char* buffer, int* pos, int buffer_size)
 {
@@ -12,14 +30,14 @@ void tree_to_string_simple(node_t* node, char* buffer, int* pos, int buffer_size
     switch (node -> type)
     {
         case NODE_NUM:
-            *pos += snprintf(buffer + *pos, buffer_size - *pos, "%g", node -> data.num_value);
+            append_to_buffer(buffer, pos, buffer_size, "%g", node -> data.num_value);
             break;
 
         case NODE_VAR:
             if (node -> data.var_definition.name)
-                *pos += snprintf(buffer + *pos, buffer_size - *pos, "%s", node -> data.var_definition.name);
+                append_to_buffer(buffer, pos, buffer_size, "%s", node -> data.var_definition.name);
             else
-                *pos += snprintf(buffer + *pos, buffer_size - *pos, "?");
+                append_to_buffer(buffer, pos, buffer_size, "?");
             break;
 
         case NODE_OP:
@@ -44,22 +62,22 @@ void tree_to_string_simple(node_t* node, char* buffer, int* pos, int buffer_size
                     case OP_ADD:
                         if (left_needs_parentheses)
                         {
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, "(");
+                            append_to_buffer(buffer, pos, buffer_size, "(");
                             tree_to_string_simple(node -> left, buffer, pos, buffer_size);
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, ")");
+                            append_to_buffer(buffer, pos, buffer_size, ")");
                         }
                         else
                         {
                             tree_to_string_simple(node -> left, buffer, pos, buffer_size);
                         }
 
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, " + ");
+                        append_to_buffer(buffer, pos, buffer_size, " + ");
 
                         if (right_needs_parentheses)
                         {
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, "(");
+                            append_to_buffer(buffer, pos, buffer_size, "(");
                             tree_to_string_simple(node -> right, buffer, pos, buffer_size);
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, ")");
+                            append_to_buffer(buffer, pos, buffer_size, ")");
                         }
                         else
                         {
@@ -69,22 +87,22 @@ void tree_to_string_simple(node_t* node, char* buffer, int* pos, int buffer_size
                     case OP_SUB:
                         if (left_needs_parentheses)
                         {
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, "(");
+                            append_to_buffer(buffer, pos, buffer_size, "(");
                             tree_to_string_simple(node -> left, buffer, pos, buffer_size);
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, ")");
+                            append_to_buffer(buffer, pos, buffer_size, ")");
                         }
                         else
                         {
                             tree_to_string_simple(node -> left, buffer, pos, buffer_size);
                         }
 
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, " - ");
+                        append_to_buffer(buffer, pos, buffer_size, " - ");
 
                         if (right_needs_parentheses)
                         {
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, "(");
+                            append_to_buffer(buffer, pos, buffer_size, "(");
                             tree_to_string_simple(node -> right, buffer, pos, buffer_size);
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, ")");
+                            append_to_buffer(buffer, pos, buffer_size, ")");
                         }
                         else
                         {
@@ -95,22 +113,22 @@ void tree_to_string_simple(node_t* node, char* buffer, int* pos, int buffer_size
                     case OP_MUL:
                         if (left_needs_parentheses)
                         {
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, "(");
+                            append_to_buffer(buffer, pos, buffer_size, "(");
                             tree_to_string_simple(node -> left, buffer, pos, buffer_size);
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, ")");
+                            append_to_buffer(buffer, pos, buffer_size, ")");
                         }
                         else
                         {
                             tree_to_string_simple(node -> left, buffer, pos, buffer_size);
                         }
 
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, " \\cdot ");
+                        append_to_buffer(buffer, pos, buffer_size, " \\cdot ");
 
                         if (right_needs_parentheses)
                         {
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, "(");
+                            append_to_buffer(buffer, pos, buffer_size, "(");
                             tree_to_string_simple(node -> right, buffer, pos, buffer_size);
-                            *pos += snprintf(buffer + *pos, buffer_size - *pos, ")");
+                            append_to_buffer(buffer, pos, buffer_size, ")");
                         }
                         else
                         {
@@ -118,47 +136,47 @@ void tree_to_string_simple(node_t* node, char* buffer, int* pos, int buffer_size
                         }
                         break;
                     case OP_DIV:
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "\\frac{");
+                        append_to_buffer(buffer, pos, buffer_size, "\\frac{");
                         tree_to_string_simple(node -> left,  buffer, pos, buffer_size);
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "}{");
+                        append_to_buffer(buffer, pos, buffer_size, "}{");
                         tree_to_string_simple(node -> right, buffer, pos, buffer_size);
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "}");
+                        append_to_buffer(buffer, pos, buffer_size, "}");
                         break;
                     case OP_SIN:
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "\\sin(");
+                        append_to_buffer(buffer, pos, buffer_size, "\\sin(");
                         tree_to_string_simple(node -> right, buffer, pos, buffer_size);
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, ")");
+                        append_to_buffer(buffer, pos, buffer_size, ")");
                         break;
                     case OP_COS:
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "\\cos(");
+                        append_to_buffer(buffer, pos, buffer_size, "\\cos(");
                         tree_to_string_simple(node -> right, buffer, pos, buffer_size);
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, ")");
+                        append_to_buffer(buffer, pos, buffer_size, ")");
                         break;
                     case OP_POW:
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "{");
+                        append_to_buffer(buffer, pos, buffer_size, "{");
                         tree_to_string_simple(node -> left, buffer, pos, buffer_size);
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "}^{");
+                        append_to_buffer(buffer, pos, buffer_size, "}^{");
                         tree_to_string_simple(node -> right, buffer, pos, buffer_size);
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "}");
+                        append_to_buffer(buffer, pos, buffer_size, "}");
                         break;
                     case OP_LN:
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "\\ln(");
+                        append_to_buffer(buffer, pos, buffer_size, "\\ln(");
                         tree_to_string_simple(node -> right, buffer, pos, buffer_size);
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, ")");
+                        append_to_buffer(buffer, pos, buffer_size, ")");
                         break;
                     case OP_EXP:
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "e^{");
+                        append_to_buffer(buffer, pos, buffer_size, "e^{");
                         tree_to_string_simple(node -> right, buffer, pos, buffer_size);
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "}");
+                        append_to_buffer(buffer, pos, buffer_size, "}");
                         break;
                     default:
-                        *pos += snprintf(buffer + *pos, buffer_size - *pos, "?");
+                        append_to_buffer(buffer, pos, buffer_size, "?");
                 }
             }
             break;
 
         default:
-            *pos += snprintf(buffer + *pos, buffer_size - *pos, "?");
+            append_to_buffer(buffer, pos, buffer_size, "?");
     }
 }
 
@@ -230,7 +248,7 @@ char* convert_latex_to_PGF_plot(const char* latex_expr)
         }
         else if (*src == '{' || *src == '}')
         {
-            if (*(src-1) == '^' || *(src+1) == '^')
+            if ((src > latex_expr && *(src-1) == '^') || *(src+1) == '^')
             {
                 // Для степеней {} -> ()
                 if (*src == '{') *dest++ = '(';
@@ -0,0 +1,643 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "like_terms.h"
+#include "operations.h"
+#include "logic_functions.h"
+
+// Слагаемое (коэффициент при одночлене) или множитель (показатель при основании)
+struct collected_item
+{
+    node_t* node;   // NULL - элемент слит с равным ему
+    double  value;
+};
+
+struct item_list
+{
+    collected_item* items;
+    size_t          size;
+    size_t          capacity;
+};
+
+// ==================== ПРОТОТИПЫ ФУНКЦИЙ ====================
+static node_t* normalize_node(const node_t* node, budget_state* budget);
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+// Структурный хэш: равные по subtrees_equal поддеревья имеют равные хэши
+static size_t subtree_hash(const node_t* node)
+{
+    if (node == NULL)
+        return 0;
+
+    size_t hash = mix_hash((size_t)node -> type + 1, 0);
+
+    switch (node -> type)
+    {
+        case NODE_NUM:
+        {
+            double number = node -> data.num_value + 0.0;
+            uint64_t bits = 0;
+            memcpy(&bits, &number, sizeof(bits));
+            hash = mix_hash(hash, bits);
+            break;
+        }
+        case NODE_VAR:
+            hash = mix_hash(hash, node -> data.var_definition.hash);
+            break;
+        case NODE_OP:
+            hash = mix_hash(hash, (size_t)node -> data.op_value);
+            hash = mix_hash(hash, subtree_hash(node -> left));
+            hash = mix_hash(hash, subtree_hash(node -> right));
+            break;
+        default:
+            break;
+    }
+
+    return hash;
+}
+
+
+static bool subtrees_equal(const node_t* first, const node_t* second)
+{
+    if (first == second)
+        return true;
+
+    if (first == NULL || second == NULL || first -> type != second -> type)
+        return false;
+
+    switch (first -> type)
+    {
+        case NODE_NUM:
+            return !(first -> data.num_value < second -> data.num_value) &&
+                   !(first -> data.num_value > second -> data.num_value);
+
+        case NODE_VAR:
+            return first -> data.var_definition.hash == second -> data.var_definition.hash &&
+                   first -> data.var_definition.name != NULL && second -> data.var_definition.name != NULL &&
+                   strcmp(first -> data.var_definition.name, second -> data.var_definition.name) == 0;
+
+        case NODE_OP:
+            return first -> data.op_value == second -> data.op_value &&
+                   subtrees_equal(first -> left,  second -> left) &&
+                   subtrees_equal(first -> right, second -> right);
+
+        default:
+            return false;
+    }
+}
+
+
+static node_t* copy_leaf(const node_t* node)
+{
+    if (node -> type == NODE_NUM)
+        return create_num_node(node -> data.num_value);
+
+    value_of_tree_element data = {};
+    data.var_definition.name = strdup(node -> data.var_definition.name);
+    if (data.var_definition.name == NULL)
+        return NULL;
+
+    node_t* copy = create_node(NODE_VAR, data, NULL, NULL);
+    if (copy == NULL)
+        free(data.var_definition.name);
+
+    return copy;
+}
+
+
+static bool is_op(const node_t* node, operation_type op)
+{
+    return node != NULL && node -> type == NODE_OP && node -> data.op_value == op;
+}
+
+
+static bool is_num(const node_t* node)
+{
+    return node != NULL && node -> type == NODE_NUM;
+}
+
+
+static bool is_integer(double number)
+{
+    return isfinite(number) && is_zero(number - round(number));
+}
+
+
+// Отцепляет ребёнка и освобождает сам узел операции
+static node_t* unwrap_child(node_t* node, node_t* child)
+{
+    if (node -> left  == child) node -> left  = NULL;
+    if (node -> right == child) node -> right = NULL;
+
+    free_subtree(node);
+    child -> parent = NULL;
+
+    return child;
+}
+
+
+static bool push_item(item_list* list, node_t* node, double value)
+{
+    if (list -> size == list -> capacity)
+    {
+        size_t capacity = (list -> capacity == 0) ? 8 : 2 * list -> capacity;
+        collected_item* items = (collected_item*)realloc(list -> items, capacity * sizeof(collected_item));
+        if (items == NULL)
+            return false;
+
+        list -> items    = items;
+        list -> capacity = capacity;
+    }
+
+    list -> items[list -> size++] = {node, value};
+
+    return true;
+}
+
+
+static void destroy_item_list(item_list* list)
+{
+    for (size_t i = 0; i < list -> size; i++)
+        free_subtree(list -> items[i].node);
+
+    free(list -> items);
+    *list = {};
+}
+
+
+// Равные поддеревья сливаются в первое вхождение, значения складываются
+static bool merge_equal_items(item_list* list)
+{
+    size_t capacity = 16;
+    while (capacity < 2 * list -> size)
+        capacity *= 2;
+
+    size_t* table  = (size_t*)calloc(capacity, sizeof(size_t));    // номер элемента + 1
+    size_t* hashes = (size_t*)calloc(list -> size + 1, sizeof(size_t));
+    if (table == NULL || hashes == NULL)
+    {
+        free(table);
+        free(hashes);
+        return false;
+    }
+
+    size_t mask = capacity - 1;
+
+    for (size_t i = 0; i < list -> size; i++)
+    {
+        collected_item* item = &list -> items[i];
+        hashes[i] = subtree_hash(item -> node);
+
+        size_t slot = hashes[i] & mask;
+        while (table[slot] != 0)
+        {
+            size_t j = table[slot] - 1;
+            if (hashes[j] == hashes[i] && subtrees_equal(list -> items[j].node, item -> node))
+                break;
+
+            slot = (slot + 1) & mask;
+        }
+
+        if (table[slot] == 0)
+        {
+            table[slot] = i + 1;
+            continue;
+        }
+
+        list -> items[table[slot] - 1].value += item -> value;
+        free_subtree(item -> node);
+        item -> node = NULL;
+    }
+
+    free(table);
+    free(hashes);
+
+    return true;
+}
+
+
+// Сбалансированное дерево из items[begin..end); элементы забираются, NULL среди них даёт NULL
+static node_t* build_balanced(node_t** items, size_t begin, size_t end, operation_type op)
+{
+    if (end - begin == 1)
+        return items[begin];
+
+    size_t middle = begin + (end - begin) / 2;
+
+    node_t* left  = build_balanced(items, begin,  middle, op);
+    node_t* right = build_balanced(items, middle, end,    op);
+
+    return create_checked_op(op, left, right);
+}
+
+
+// coefficient * rest; при rest = 1 / d коэффициент встаёт в числитель
+static node_t* build_term(double coefficient, node_t* rest)
+{
+    if (rest == NULL)
+        return create_num_node(coefficient);
+
+    if (is_one(coefficient))
+        return rest;
+
+    if (is_op(rest, OP_DIV) && is_num(rest -> left) && is_one(rest -> left -> data.num_value))
+    {
+        rest -> left -> data.num_value = coefficient;
+        return rest;
+    }
+
+    return create_checked_op(OP_MUL, create_num_node(coefficient), rest);
+}
+
+
+// Обратное к build_term: коэффициент при нормализованном узле
+static node_t* split_coefficient(node_t* node, double* coefficient)
+{
+    *coefficient = 1.0;
+
+    if (is_num(node))
+    {
+        *coefficient = node -> data.num_value;
+        free_subtree(node);
+        return NULL;
+    }
+
+    if (is_op(node, OP_MUL) && is_num(node -> left))
+    {
+        *coefficient = node -> left -> data.num_value;
+        return unwrap_child(node, node -> right);
+    }
+
+    if (is_op(node, OP_DIV) && is_num(node -> left))
+    {
+        *coefficient = node -> left -> data.num_value;
+        node -> left -> data.num_value = 1.0;
+    }
+
+    return node;
+}
+
+
+static node_t* negate_term(node_t* node)
+{
+    if (node == NULL)
+        return NULL;
+
+    if (is_num(node))
+    {
+        node -> data.num_value = -node -> data.num_value;
+        return node;
+    }
+
+    if ((is_op(node, OP_MUL) || is_op(node, OP_DIV)) && is_num(node -> left))
+    {
+        node -> left -> data.num_value = -node -> left -> data.num_value;
+        return node;
+    }
+
+    return create_checked_op(OP_MUL, create_num_node(-1.0), node);
+}
+
+// ==================== ПРОИЗВЕДЕНИЯ ====================
+
+static bool is_product(const node_t* node)
+{
+    return is_op(node, OP_MUL) || is_op(node, OP_DIV) || (is_op(node, OP_POW) && is_num(node -> right));
+}
+
+
+static bool collect_factors(const node_t* node, double exponent, double* coefficient, item_list* factors,
+                            budget_state* budget)
+{
+    // (a * b)^k = a^k * b^k и (a^m)^k = a^(m * k) верны для любых a, b только при целом k
+    if (is_integer(exponent) && is_product(node))
+    {
+        switch (node -> data.op_value)
+        {
+            case OP_MUL:
+                return collect_factors(node -> left,  exponent, coefficient, factors, budget) &&
+                       collect_factors(node -> right, exponent, coefficient, factors, budget);
+            case OP_DIV:
+                return collect_factors(node -> left,  exponent,  coefficient, factors, budget) &&
+                       collect_factors(node -> right, -exponent, coefficient, factors, budget);
+            case OP_POW:
+                return collect_factors(node -> left, exponent * node -> right -> data.num_value, coefficient, factors, budget);
+            case OP_ADD:
+            case OP_SUB:
+            case OP_SIN:
+            case OP_COS:
+            case OP_LN:
+            case OP_EXP:
+            default:
+                break;
+        }
+    }
+
+    node_t* base = normalize_node(node, budget);
+    if (base == NULL)
+        return false;
+
+    if (is_num(base))
+    {
+        double power = pow(base -> data.num_value, exponent);
+        if (isfinite(power))
+        {
+            *coefficient *= power;
+            free_subtree(base);
+            return true;
+        }
+    }
+
+    if (is_integer(exponent) && is_op(base, OP_POW) && is_num(base -> right))
+    {
+        exponent *= base -> right -> data.num_value;
+        base = unwrap_child(base, base -> left);
+    }
+
+    if (!push_item(factors, base, exponent))
+    {
+        free_subtree(base);
+        return false;
+    }
+
+    return true;
+}
+
+
+static node_t* build_power(node_t* base, double exponent)
+{
+    if (is_one(exponent))
+        return base;
+
+    return create_checked_op(OP_POW, base, create_num_node(exponent));
+}
+
+
+// Произведение как coefficient * rest, rest = NULL - произведение равно числу
+static bool normalize_product(const node_t* node, double* coefficient, node_t** rest, budget_state* budget)
+{
+    *coefficient = 1.0;
+    *rest        = NULL;
+
+    item_list factors = {};
+    if (!collect_factors(node, 1.0, coefficient, &factors, budget) || !merge_equal_items(&factors))
+    {
+        destroy_item_list(&factors);
+        return false;
+    }
+
+    node_t** numerator   = (node_t**)calloc(factors.size + 1, sizeof(node_t*));
+    node_t** denominator = (node_t**)calloc(factors.size + 1, sizeof(node_t*));
+    if (numerator == NULL || denominator == NULL)
+    {
+        free(numerator);
+        free(denominator);
+        destroy_item_list(&factors);
+        return false;
+    }
+
+    // несвернувшееся число (0^-1 из деления на ноль) не даёт нулевому коэффициенту обнулить произведение
+    bool singular = false;
+    for (size_t i = 0; i < factors.size; i++)
+        singular |= is_num(factors.items[i].node);
+
+    bool vanishes = is_zero(*coefficient) && !singular;
+
+    size_t numerator_size   = 0;
+    size_t denominator_size = 0;
+
+    for (size_t i = 0; i < factors.size; i++)
+    {
+        collected_item* factor = &factors.items[i];
+        if (factor -> node == NULL)
+            continue;
+
+        if (vanishes || is_zero(factor -> value))
+            free_subtree(factor -> node);
+        else if (factor -> value > 0)
+            numerator[numerator_size++]     = build_power(factor -> node, factor -> value);
+        else
+            denominator[denominator_size++] = build_power(factor -> node, -factor -> value);
+
+        factor -> node = NULL;
+    }
+
+    destroy_item_list(&factors);
+
+    node_t* upper = (numerator_size   > 0) ? build_balanced(numerator,   0, numerator_size,   OP_MUL) : NULL;
+    node_t* lower = (denominator_size > 0) ? build_balanced(denominator, 0, denominator_size, OP_MUL) : NULL;
+
+    free(numerator);
+    free(denominator);
+
+    if ((numerator_size > 0 && upper == NULL) || (denominator_size > 0 && lower == NULL))
+    {
+        free_subtree(upper);
+        free_subtree(lower);
+        return false;
+    }
+
+    *rest = (lower != NULL) ? create_checked_op(OP_DIV, (upper != NULL) ? upper : create_num_node(1.0), lower) : upper;
+    if (lower != NULL && *rest == NULL)
+        return false;
+
+    if (singular && is_zero(*coefficient) && *rest != NULL)
+    {
+        *rest        = create_checked_op(OP_MUL, create_num_node(*coefficient), *rest);
+        *coefficient = 1.0;
+        return *rest != NULL;
+    }
+
+    return true;
+}
+
+// ==================== СУММЫ ====================
+
+static bool collect_terms(const node_t* node, double sign, double* constant, item_list* terms, budget_state* budget)
+{
+    if (is_op(node, OP_ADD) || is_op(node, OP_SUB))
+        return collect_terms(node -> left, sign, constant, terms, budget) &&
+               collect_terms(node -> right, is_op(node, OP_SUB) ? -sign : sign, constant, terms, budget);
+
+    double  coefficient = 1.0;
+    node_t* rest        = NULL;
+
+    if (is_product(node))
+    {
+        if (!normalize_product(node, &coefficient, &rest, budget))
+            return false;
+    }
+    else
+    {
+        node_t* normalized = normalize_node(node, budget);
+        if (normalized == NULL)
+            return false;
+
+        rest = split_coefficient(normalized, &coefficient);
+    }
+
+    if (rest == NULL)
+    {
+        *constant += sign * coefficient;
+        return true;
+    }
+
+    if (!push_item(terms, rest, sign * coefficient))
+    {
+        free_subtree(rest);
+        return false;
+    }
+
+    return true;
+}
+
+
+static node_t* normalize_sum(const node_t* node, budget_state* budget)
+{
+    item_list terms = {};
+    double constant = 0.0;
+
+    if (!collect_terms(node, 1.0, &constant, &terms, budget) || !merge_equal_items(&terms))
+    {
+        destroy_item_list(&terms);
+        return NULL;
+    }
+
+    node_t** positive = (node_t**)calloc(terms.size + 1, sizeof(node_t*));
+    node_t** negative = (node_t**)calloc(terms.size + 1, sizeof(node_t*));
+    if (positive == NULL || negative == NULL)
+    {
+        free(positive);
+        free(negative);
+        destroy_item_list(&terms);
+        return NULL;
+    }
+
+    size_t positive_size = 0;
+    size_t negative_size = 0;
+
+    for (size_t i = 0; i < terms.size; i++)
+    {
+        collected_item* term = &terms.items[i];
+        if (term -> node == NULL)
+            continue;
+
+        if (is_zero(term -> value))
+            free_subtree(term -> node);
+        else if (term -> value > 0)
+            positive[positive_size++] = build_term(term -> value, term -> node);
+        else
+            negative[negative_size++] = build_term(-term -> value, term -> node);
+
+        term -> node = NULL;
+    }
+
+    destroy_item_list(&terms);
+
+    // свободный член - последним
+    if (!is_zero(constant))
+    {
+        if (constant > 0)
+            positive[positive_size++] = create_num_node(constant);
+        else
+            negative[negative_size++] = create_num_node(-constant);
+    }
+
+    node_t* result = NULL;
+    size_t  first  = 0;
+
+    if (positive_size > 0)
+        result = build_balanced(positive, 0, positive_size, OP_ADD);
+    else if (negative_size > 0)
+        result = negate_term(negative[first++]);
+    else
+        result = create_num_node(0.0);
+
+    if (first < negative_size)
+        result = create_checked_op(OP_SUB, result, build_balanced(negative, first, negative_size, OP_ADD));
+
+    free(positive);
+    free(negative);
+
+    return result;
+}
+
+// ==================== НОРМАЛИЗАЦИЯ ====================
+
+// Возвращает новое дерево, исходное не меняется; NULL - ошибка выделения или исчерпан бюджет
+static node_t* normalize_node(const node_t* node, budget_state* budget)
+{
+    if (node == NULL || (budget != NULL && budget_exceeded(budget)))
+        return NULL;
+
+    if (node -> type == NODE_NUM || node -> type == NODE_VAR)
+        return copy_leaf(node);
+
+    if (node -> type != NODE_OP)
+        return NULL;
+
+    if (is_op(node, OP_ADD) || is_op(node, OP_SUB))
+        return normalize_sum(node, budget);
+
+    if (is_product(node))
+    {
+        double  coefficient = 1.0;
+        node_t* rest        = NULL;
+
+        if (!normalize_product(node, &coefficient, &rest, budget))
+            return NULL;
+
+        if (is_zero(coefficient))
+        {
+            free_subtree(rest);
+            return create_num_node(0.0);
+        }
+
+        return build_term(coefficient, rest);
+    }
+
+    node_t* left = NULL;
+    if (node -> left != NULL && (left = normalize_node(node -> left, budget)) == NULL)
+        return NULL;
+
+    node_t* right = normalize_node(node -> right, budget);
+    if (right == NULL)
+    {
+        free_subtree(left);
+        return NULL;
+    }
+
+    double folded = 0.0;
+    if (is_num(right) && (left == NULL || is_num(left)) &&
+        fold_numbers(node -> data.op_value, (left != NULL) ? left -> data.num_value : 0.0, right -> data.num_value, &folded))
+    {
+        free_subtree(left);
+        free_subtree(right);
+        return create_num_node(folded);
+    }
+
+    return create_checked_op(node -> data.op_value, left, right);
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+// Нормальная форма строится копией: при ошибке выделения или исчерпании бюджета дерево остаётся прежним
+tree_error_type collect_like_terms(tree_t* tree, budget_state* budget)
+{
+    if (tree == NULL || tree -> root == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    node_t* normalized = normalize_node(tree -> root, budget);
+    if (normalized == NULL)
+        return (budget != NULL && budget_exceeded(budget)) ? TREE_ERROR_BUDGET_EXCEEDED : TREE_ERROR_ALLOCATION;
+
+    free_subtree(tree -> root);
+    tree -> root = normalized;
+    tree -> size = count_tree_nodes(normalized);
+
+    return TREE_ERROR_NO;
+}
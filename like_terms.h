@@ -0,0 +1,21 @@
+#ifndef LIKE_TERMS_H_
+#define LIKE_TERMS_H_
+
+#include "tree_common.h"
+#include "operations.h"
+#include "tree_error_types.h"
+
+// Приводит дерево к нормальной форме многочленного вида. Цепочки + и - разворачиваются
+// в список слагаемых коэффициент * одночлен, цепочки *, / и ^ с числовым показателем -
+// в список множителей основание^показатель. Равные одночлены и основания складываются
+// (5*x + 3*x = 8*x, x*x^2/x = x^2), числа сворачиваются, слагаемые с нулевым коэффициентом
+// и множители с нулевым показателем исчезают. Списки собираются обратно сбалансированными
+// деревьями: глубина цепочки из n операндов - log n вместо n.
+// Показатели перемножаются и скобки со степенью раскрываются только при целом внешнем
+// показателе, поэтому значения в точках, где исходное дерево определено, сохраняются
+// (как и у optimize_tree_with_dump, теряются лишь неопределённости вида x/x).
+// budget - состояние текущего запуска оптимизатора (NULL - без ограничений); при его
+// исчерпании возвращается TREE_ERROR_BUDGET_EXCEEDED, а дерево не меняется
+tree_error_type collect_like_terms(tree_t* tree, budget_state* budget);
+
+#endif // LIKE_TERMS_H_
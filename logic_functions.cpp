@@ -4,19 +4,19 @@
 
 bool is_zero(double number)
 {
-    return fabs(number) < 1e-10;
+    return fabs(number) < ZERO_EPSILON;
 }
 
 
 bool is_one(double number)
 {
-    return fabs(number - 1) < 1e-10;
+    return fabs(number - 1) < ZERO_EPSILON;
 }
 
 
 bool is_minus_one(double number)
 {
-    return fabs(number + 1) < 1e-10;
+    return fabs(number + 1) < ZERO_EPSILON;
 }
 
 
@@ -30,3 +30,10 @@ bool is_binary(operation_type op)
 {
     return (op == OP_ADD || op == OP_SUB || op == OP_MUL || op == OP_DIV || op == OP_POW);
 }
+
+
+size_t mix_hash(size_t hash, size_t value)
+{
+    hash = (hash ^ value) * 0xFF51AFD7ED558CCDull;
+    return hash ^ (hash >> 32);
+}
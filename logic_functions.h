@@ -5,10 +5,17 @@
 
 #include "tree_common.h"
 
+// Порог, ниже которого число считается нулём: общий для дерева, интерпретатора,
+// блочного вычисления и нативного кода, чтобы ошибки совпадали во всех режимах
+const double ZERO_EPSILON = 1e-10;
+
 bool is_zero     (double number);
 bool is_one      (double number);
 bool is_minus_one(double number);
 bool is_unary    (operation_type op);
 bool is_binary   (operation_type op);
 
+// Добавляет value в структурный хэш поддерева
+size_t mix_hash(size_t hash, size_t value);
+
 #endif // LOGIC_FUNCTIONS_H_
@@ -45,9 +45,11 @@ int main(int argc, const char** argv)
 
     if (error == TREE_ERROR_NO) error = perform_differentiation_process(diff_struct);
 
-    if (error == TREE_ERROR_NO && diff_struct -> tex_file)
+    // документ закрывается и после ошибки, чтобы full_analysis.tex оставался корректным
+    if (diff_struct -> tex_file)
     {
-        error = finalize_latex_output(diff_struct);
+        tree_error_type finalize_error = finalize_latex_output(diff_struct);
+        if (error == TREE_ERROR_NO) error = finalize_error;
     }
 
     close_tree_log("differenciator_tree");
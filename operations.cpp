@@ -3,15 +3,20 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdarg.h>
+#include <time.h>
 #include "assert.h"
 
 #include "dump.h"
 #include "tree_base.h"
 #include "operations.h"
 #include "latex_dump.h"
+#include "like_terms.h"
 #include "tree_common.h"
 #include "variable_parse.h"
 #include "logic_functions.h"
+#include "power_reduction.h"
+#include "rewrite_rules.h"
+#include "thread_pool.h"
 #include "tree_error_types.h"
 
 
@@ -37,27 +42,141 @@
         } \
     } while(0)
 
+// Узлы, созданные текущим потоком: бюджет запуска - разность счётчика с его началом
+static thread_local size_t created_nodes = 0;
+
+// часы опрашиваются не на каждой проверке бюджета
+const size_t BUDGET_CLOCK_INTERVAL = 256;
+
+// потоки параллельного запуска добавляют свои узлы в общий счётчик порциями
+const size_t BUDGET_SHARE_INTERVAL = 1024;
+
+// Состояние одного запуска differentiate_tree
+struct differentiation_context
+{
+    const char*  variable_name;
+    thread_pool* pool;         // NULL - без развилок по слагаемым сумм
+    size_t       forks_left;   // сколько ещё вложенных сумм можно делить на задачи
+    budget_state budget;
+    bool         failed;
+};
+
 // ==================== ПРОТОТИПЫ ФУНКЦИЙ ====================
-static node_t* differentiate_add_sub(node_t* node, const char* variable_name, operation_type op);
-static node_t* differentiate_mul   (node_t* node, const char* variable_name);
-static node_t* differentiate_div   (node_t* node, const char* variable_name);
-static node_t* differentiate_sin   (node_t* node, const char* variable_name);
-static node_t* differentiate_cos   (node_t* node, const char* variable_name);
-static node_t* differentiate_pow   (node_t* node, const char* variable_name);
-static node_t* differentiate_ln    (node_t* node, const char* variable_name);
-static node_t* differentiate_exp   (node_t* node, const char* variable_name);
+static node_t* differentiate_add_sub(node_t* node, differentiation_context* context, operation_type op);
+static node_t* differentiate_mul   (node_t* node, differentiation_context* context);
+static node_t* differentiate_div   (node_t* node, differentiation_context* context);
+static node_t* differentiate_sin   (node_t* node, differentiation_context* context);
+static node_t* differentiate_cos   (node_t* node, differentiation_context* context);
+static node_t* differentiate_pow   (node_t* node, differentiation_context* context);
+static node_t* differentiate_ln    (node_t* node, differentiation_context* context);
+static node_t* differentiate_exp   (node_t* node, differentiation_context* context);
 static node_t* differentiate_power_var_const(node_t* u, node_t* v, node_t* du_dx, node_t* dv_dx);
 static node_t* differentiate_power_const_var(node_t* u, node_t* v, node_t* du_dx, node_t* dv_dx);
 static node_t* differentiate_power_var_var  (node_t* u, node_t* v, node_t* du_dx, node_t* dv_dx);
-static node_t* differentiate_node(node_t* node, const char* variable_name);
+static node_t* differentiate_node(node_t* node, differentiation_context* context);
+static bool    is_large_subtree(node_t* node);
+static node_t* differentiate_sum_parallel(node_t* node, differentiation_context* context);
 static void  free_nodes(int count, ...);
-static bool  contains_variable(node_t* node, const char* variable_name);
 static void  replace_node(node_t** node_ptr, node_t* new_node);
 
 
 // ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
 
 
+static double budget_clock_seconds()
+{
+    timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+
+void budget_start(budget_state* state, const computation_budget* budget)
+{
+    state -> budget         = budget;
+    state -> nodes_at_start = created_nodes;
+    state -> start_time     = (budget != NULL && budget -> max_seconds > 0) ? budget_clock_seconds() : 0.0;
+    state -> checks         = 0;
+    state -> exceeded       = false;
+    state -> shared_nodes   = NULL;
+    state -> shared_local   = 0;
+}
+
+
+static void budget_flush(budget_state* state)
+{
+    if (state -> shared_nodes == NULL)
+        return;
+
+    size_t local = created_nodes - state -> nodes_at_start;
+    state -> shared_nodes -> fetch_add(local - state -> shared_local, std::memory_order_relaxed);
+    state -> shared_local = local;
+}
+
+
+// Узлы запуска: общий счётчик и свои, ещё не добавленные в него
+static size_t budget_used_nodes(budget_state* state)
+{
+    size_t local = created_nodes - state -> nodes_at_start;
+    if (state -> shared_nodes == NULL)
+        return local;
+
+    if (local - state -> shared_local >= BUDGET_SHARE_INTERVAL)
+        budget_flush(state);
+
+    return state -> shared_nodes -> load(std::memory_order_relaxed) + (local - state -> shared_local);
+}
+
+
+// Перед развилкой: запуск без общего счётчика заводит counter, иначе досылает свои узлы в уже общий
+static void budget_share(budget_state* state, std::atomic<size_t>* counter)
+{
+    if (state -> shared_nodes != NULL)
+    {
+        budget_flush(state);
+        return;
+    }
+
+    state -> shared_local = created_nodes - state -> nodes_at_start;
+    state -> shared_nodes = counter;
+    counter -> store(state -> shared_local, std::memory_order_relaxed);
+}
+
+
+// После развилки: узлы первого куска созданы этим же потоком, и кусок уже добавил их сам
+static void budget_collect(budget_state* state, std::atomic<size_t>* counter)
+{
+    if (state -> shared_nodes != counter)
+    {
+        state -> shared_local = created_nodes - state -> nodes_at_start;
+        return;
+    }
+
+    // весь расход снова считается своим: начало отсчёта сдвигается на узлы других потоков
+    state -> nodes_at_start = created_nodes - counter -> load(std::memory_order_relaxed);
+    state -> shared_nodes   = NULL;
+    state -> shared_local   = 0;
+}
+
+
+bool budget_exceeded(budget_state* state)
+{
+    if (state -> budget == NULL || state -> exceeded)
+        return state -> exceeded;
+
+    const computation_budget* budget = state -> budget;
+
+    if (budget -> max_nodes > 0 && budget_used_nodes(state) > budget -> max_nodes)
+        state -> exceeded = true;
+    else if (budget -> max_seconds > 0 && ++state -> checks % BUDGET_CLOCK_INTERVAL == 0 &&
+             budget_clock_seconds() - state -> start_time > budget -> max_seconds)
+        state -> exceeded = true;
+
+    return state -> exceeded;
+}
+
+
 void free_subtree(node_t* node)
 {
     if (node == NULL)
@@ -86,8 +205,14 @@ static void free_nodes(int count, ...)
 }
 
 
-static node_t* create_checked_op(operation_type op, node_t* left, node_t* right)
+node_t* create_checked_op(operation_type op, node_t* left, node_t* right)
 {
+    if (right == NULL || (is_binary(op) && left == NULL))
+    {
+        free_nodes(2, left, right);
+        return NULL;
+    }
+
     node_t* result = CREATE_OP(op, left, right);
     RELEASE_IF_NULL(result, left, right);
 
@@ -95,6 +220,12 @@ static node_t* create_checked_op(operation_type op, node_t* left, node_t* right)
 }
 
 
+node_t* create_num_node(double value)
+{
+    return CREATE_NUM(value);
+}
+
+
 static node_t* create_checked_unary_op(operation_type op, node_t* right)
 {
     node_t* result = CREATE_UNARY_OP(op, right);
@@ -104,6 +235,141 @@ static node_t* create_checked_unary_op(operation_type op, node_t* right)
 }
 
 
+// ==================== УПРОЩАЮЩИЕ КОНСТРУКТОРЫ ====================
+
+
+// Правила дифференцирования строят узлы через create_simplified_op и create_simplified_unary_op:
+// числа сворачиваются, 0 + a, a - 0, 1 * a, a / 1, a ^ 1 сразу дают a.
+// Выбрасываются только числовые листья: упрощения вроде 0 * a, отбрасывающие
+// целое поддерево, остаются оптимизатору
+static bool is_num_node(node_t* node)
+{
+    return node != NULL && node -> type == NODE_NUM;
+}
+
+
+bool fold_numbers(operation_type op, double left_val, double right_val, double* result)
+{
+    switch (op)
+    {
+        case OP_ADD: *result = left_val + right_val; return true;
+        case OP_SUB: *result = left_val - right_val; return true;
+        case OP_MUL: *result = left_val * right_val; return true;
+        case OP_DIV:
+            if (is_zero(right_val))
+                return false;
+            *result = left_val / right_val;
+            return true;
+        case OP_POW:
+            *result = pow(left_val, right_val);
+            return isfinite(*result);
+        case OP_SIN: *result = sin(right_val); return true;
+        case OP_COS: *result = cos(right_val); return true;
+        case OP_EXP: *result = exp(right_val); return true;
+        case OP_LN:
+            if (right_val <= 0)
+                return false;
+            *result = log(right_val);
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+// Забирает left и right; при ошибке выделения оба освобождаются
+static node_t* create_simplified_op(operation_type op, node_t* left, node_t* right)
+{
+    if (!left || !right)
+    {
+        free_nodes(2, left, right);
+        return NULL;
+    }
+
+    double folded = 0.0;
+    if (is_num_node(left) && is_num_node(right) &&
+        fold_numbers(op, left -> data.num_value, right -> data.num_value, &folded))
+    {
+        free_nodes(2, left, right);
+        return CREATE_NUM(folded);
+    }
+
+    node_t* kept    = NULL;
+    node_t* dropped = NULL;
+
+    switch (op)
+    {
+        case OP_ADD:
+            if (is_num_node(left) && is_zero(left -> data.num_value))
+            {
+                kept = right; dropped = left;
+            }
+            else if (is_num_node(right) && is_zero(right -> data.num_value))
+            {
+                kept = left; dropped = right;
+            }
+            break;
+
+        case OP_SUB:
+            if (is_num_node(right) && is_zero(right -> data.num_value))
+            {
+                kept = left; dropped = right;
+            }
+            break;
+
+        case OP_MUL:
+            if (is_num_node(left) && is_one(left -> data.num_value))
+            {
+                kept = right; dropped = left;
+            }
+            else if (is_num_node(right) && is_one(right -> data.num_value))
+            {
+                kept = left; dropped = right;
+            }
+            break;
+
+        case OP_DIV:
+        case OP_POW:
+            if (is_num_node(right) && is_one(right -> data.num_value))
+            {
+                kept = left; dropped = right;
+            }
+            break;
+
+        case OP_SIN:
+        case OP_COS:
+        case OP_LN:
+        case OP_EXP:
+        default:
+            break;
+    }
+
+    if (kept != NULL)
+    {
+        free_subtree(dropped);
+        return kept;
+    }
+
+    return create_checked_op(op, left, right);
+}
+
+
+static node_t* create_simplified_unary_op(operation_type op, node_t* right)
+{
+    if (!right)
+        return NULL;
+
+    double folded = 0.0;
+    if (is_num_node(right) && fold_numbers(op, 0.0, right -> data.num_value, &folded))
+    {
+        free_subtree(right);
+        return CREATE_NUM(folded);
+    }
+
+    return create_checked_unary_op(op, right);
+}
+
+
 static tree_error_type evaluate_tree_recursive(node_t* node, variable_table* var_table, double* result, int depth)
 {
     if (node == NULL)
@@ -165,7 +431,7 @@ static tree_error_type evaluate_tree_recursive(node_t* node, variable_table* var
                         *result = cos(right_result);
                         break;
                     case OP_POW:
-                        *result = pow(left_result, right_result);
+                        *result = reduced_pow(left_result, right_result);
                         break;
                     case OP_LN:
                         if (right_result <= 0)
@@ -243,6 +509,8 @@ node_t* create_node(node_type type, value_of_tree_element data, node_t* left, no
     if (!node)
         return NULL;
 
+    created_nodes++;
+
     node -> type = type;
     node -> left = left;
     node -> right = right;
@@ -307,55 +575,114 @@ static node_t* copy_node(node_t* original)
 }
 
 
-static bool contains_variable(node_t* node, const char* variable_name)
+// ==================== ФУНКЦИИ ДИФФЕРЕНЦИРОВАНИЯ ====================
+
+
+// Производная поддерева без переменной дифференцирования сворачивается
+// в одиночный ноль ещё у листьев, поэтому правила проверяют только корень
+static bool is_zero_leaf(node_t* node)
 {
-    if (node == NULL)
-        return false;
+    return node != NULL && node -> type == NODE_NUM && is_zero(node -> data.num_value);
+}
 
-    unsigned int target_hash = compute_hash(variable_name);
 
-    switch (node -> type)
+static node_t* create_negation(node_t* node)
+{
+    node_t* minus_one = CREATE_NUM(-1.0);
+    if (!minus_one)
     {
-        case NODE_VAR:
-            return (node -> data.var_definition.hash == target_hash) &&
-                   (node -> data.var_definition.name != NULL)        &&
-                   (strcmp(node -> data.var_definition.name, variable_name) == 0);
+        free_nodes(1, node);
+        return NULL;
+    }
 
-        case NODE_OP:
-            return contains_variable(node -> left, variable_name) ||
-                   contains_variable(node -> right, variable_name);
+    return create_simplified_op(OP_MUL, minus_one, node);
+}
 
-        case NODE_NUM:
-        default:
-            return false;
+
+// Забирает обе производные; при NULL одной из них освобождает другую
+static node_t* combine_sum_derivatives(operation_type op, node_t* left_deriv, node_t* right_deriv)
+{
+    if (!left_deriv || !right_deriv)
+    {
+        free_nodes(2, left_deriv, right_deriv);
+        return NULL;
+    }
+
+    if (is_zero_leaf(right_deriv))
+    {
+        free_subtree(right_deriv);
+        return left_deriv;
     }
+
+    if (is_zero_leaf(left_deriv))
+    {
+        free_subtree(left_deriv);
+        return (op == OP_ADD) ? right_deriv : create_negation(right_deriv);
+    }
+
+    return create_simplified_op(op, left_deriv, right_deriv);
 }
 
 
-// ==================== ФУНКЦИИ ДИФФЕРЕНЦИРОВАНИЯ ====================
+static node_t* differentiate_add_sub(node_t* node, differentiation_context* context, operation_type op)
+{
+    if (context -> pool != NULL && context -> forks_left > 0)
+    {
+        if (is_large_subtree(node))
+            return differentiate_sum_parallel(node, context);
+
+        // в малом поддереве нет больших сумм: без пула вложенные + не пересчитывают размер
+        thread_pool* pool = context -> pool;
+        context -> pool = NULL;
+        node_t* result = differentiate_add_sub(node, context, op);
+        context -> pool = pool;
+
+        return result;
+    }
+
+    node_t* left_deriv  = differentiate_node(node -> left,  context);
+    node_t* right_deriv = differentiate_node(node -> right, context);
+
+    return combine_sum_derivatives(op, left_deriv, right_deriv);
+}
 
 
-static node_t* differentiate_add_sub(node_t* node, const char* variable_name, operation_type op)
+static node_t* differentiate_mul(node_t* node, differentiation_context* context)
 {
-    node_t* left_deriv  = differentiate_node(node -> left,  variable_name);
-    node_t* right_deriv = differentiate_node(node -> right, variable_name);
+    node_t* du_dx = differentiate_node(node -> left,  context);
+    node_t* dv_dx = differentiate_node(node -> right, context);
 
-    if (!left_deriv || !right_deriv)
+    if (!du_dx || !dv_dx)
     {
-        free_nodes(2, left_deriv, right_deriv);
+        free_nodes(2, du_dx, dv_dx);
         return NULL;
     }
 
-    return create_checked_op(op, left_deriv, right_deriv);
-}
+    // от переменной зависит не больше одного множителя: строится только живое слагаемое
+    if (is_zero_leaf(du_dx) || is_zero_leaf(dv_dx))
+    {
+        bool is_left_constant = is_zero_leaf(du_dx);
+        if (is_left_constant && is_zero_leaf(dv_dx))
+        {
+            free_subtree(dv_dx);
+            return du_dx;
+        }
 
+        node_t* factor     = copy_node(is_left_constant ? node -> left : node -> right);
+        node_t* derivative = is_left_constant ? dv_dx : du_dx;
+        free_subtree(is_left_constant ? du_dx : dv_dx);
+
+        if (!factor)
+        {
+            free_nodes(1, derivative);
+            return NULL;
+        }
+
+        return create_simplified_op(OP_MUL, factor, derivative);
+    }
 
-static node_t* differentiate_mul(node_t* node, const char* variable_name)
-{
     node_t* u = copy_node(node -> left);
     node_t* v = copy_node(node -> right);
-    node_t* du_dx = differentiate_node(node -> left,  variable_name);
-    node_t* dv_dx = differentiate_node(node -> right, variable_name);
 
     if (!u || !v || !du_dx || !dv_dx)
     {
@@ -363,21 +690,21 @@ static node_t* differentiate_mul(node_t* node, const char* variable_name)
         return NULL;
     }
 
-    node_t* term1 = create_checked_op(OP_MUL, u, dv_dx);
+    node_t* term1 = create_simplified_op(OP_MUL, u, dv_dx);
     if (!term1)
     {
         free_nodes(3, v, du_dx, dv_dx);
         return NULL;
     }
 
-    node_t* term2 = create_checked_op(OP_MUL, v, du_dx);
+    node_t* term2 = create_simplified_op(OP_MUL, v, du_dx);
     if (!term2)
     {
         free_nodes(2, term1, du_dx);
         return NULL;
     }
 
-    node_t* result = create_checked_op(OP_ADD, term1, term2);
+    node_t* result = create_simplified_op(OP_ADD, term1, term2);
     if (!result)
     {
         free_nodes(2, term1, term2);
@@ -387,50 +714,100 @@ static node_t* differentiate_mul(node_t* node, const char* variable_name)
 }
 
 
-static node_t* differentiate_div(node_t* node, const char* variable_name)
+static node_t* differentiate_div(node_t* node, differentiation_context* context)
 {
-    node_t* u = copy_node(node -> left);
-    node_t* v = copy_node(node -> right);
-    node_t* du_dx = differentiate_node(node -> left, variable_name);
-    node_t* dv_dx = differentiate_node(node -> right, variable_name);
+    node_t* du_dx = differentiate_node(node -> left, context);
+    node_t* dv_dx = differentiate_node(node -> right, context);
 
-    if (!u || !v || !du_dx || !dv_dx)
+    if (!du_dx || !dv_dx)
     {
-        free_nodes(4, u, v, du_dx, dv_dx);
+        free_nodes(2, du_dx, dv_dx);
         return NULL;
     }
 
-    node_t* numerator_term1 = create_checked_op(OP_MUL, v, du_dx);
-    if (!numerator_term1)
+    if (is_zero_leaf(du_dx) && is_zero_leaf(dv_dx))
     {
-        free_nodes(4, u, v, du_dx, dv_dx);
-        return NULL;
+        free_subtree(dv_dx);
+        return du_dx;
     }
 
-    node_t* numerator_term2 = create_checked_op(OP_MUL, u, dv_dx);
-    if (!numerator_term2)
+    // постоянный знаменатель: (u / c)' = u' / c
+    if (is_zero_leaf(dv_dx))
     {
-        free_nodes(3, numerator_term1, u, dv_dx);
-        return NULL;
+        free_subtree(dv_dx);
+
+        node_t* v = copy_node(node -> right);
+        if (!v)
+        {
+            free_nodes(1, du_dx);
+            return NULL;
+        }
+
+        return create_simplified_op(OP_DIV, du_dx, v);
     }
 
-    node_t* numerator = create_checked_op(OP_SUB, numerator_term1, numerator_term2);
-    if (!numerator)
+    node_t* numerator = NULL;
+
+    // постоянный числитель: (c / v)' = -(c * v') / (v * v)
+    if (is_zero_leaf(du_dx))
     {
-        free_nodes(2, numerator_term1, numerator_term2);
-        return NULL;
+        free_subtree(du_dx);
+
+        node_t* u = copy_node(node -> left);
+        if (!u)
+        {
+            free_nodes(1, dv_dx);
+            return NULL;
+        }
+
+        node_t* u_dv = create_simplified_op(OP_MUL, u, dv_dx);
+        numerator = u_dv ? create_negation(u_dv) : NULL;
+        if (!numerator)
+            return NULL;
+    }
+    else
+    {
+        node_t* u = copy_node(node -> left);
+        node_t* v = copy_node(node -> right);
+
+        if (!u || !v)
+        {
+            free_nodes(4, u, v, du_dx, dv_dx);
+            return NULL;
+        }
+
+        node_t* numerator_term1 = create_simplified_op(OP_MUL, v, du_dx);
+        if (!numerator_term1)
+        {
+            free_nodes(4, u, v, du_dx, dv_dx);
+            return NULL;
+        }
+
+        node_t* numerator_term2 = create_simplified_op(OP_MUL, u, dv_dx);
+        if (!numerator_term2)
+        {
+            free_nodes(3, numerator_term1, u, dv_dx);
+            return NULL;
+        }
+
+        numerator = create_simplified_op(OP_SUB, numerator_term1, numerator_term2);
+        if (!numerator)
+        {
+            free_nodes(2, numerator_term1, numerator_term2);
+            return NULL;
+        }
     }
 
     node_t* v_copy1 = copy_node(node -> right);
     node_t* v_copy2 = copy_node(node -> right);
-    node_t* v_squared = create_checked_op(OP_MUL, v_copy1, v_copy2);
+    node_t* v_squared = create_simplified_op(OP_MUL, v_copy1, v_copy2);
     if (!v_squared)
     {
         free_nodes(3, numerator, v_copy1, v_copy2);
         return NULL;
     }
 
-    node_t* result = create_checked_op(OP_DIV, numerator, v_squared);
+    node_t* result = create_simplified_op(OP_DIV, numerator, v_squared);
     if (!result)
         free_nodes(2, numerator, v_squared);
 
@@ -438,25 +815,27 @@ static node_t* differentiate_div(node_t* node, const char* variable_name)
 }
 
 
-static node_t* differentiate_sin(node_t* node, const char* variable_name)
+static node_t* differentiate_sin(node_t* node, differentiation_context* context)
 {
-    node_t* u = copy_node(node -> right);
-    node_t* du_dx = differentiate_node(node -> right, variable_name);
+    node_t* du_dx = differentiate_node(node -> right, context);
+    if (!du_dx || is_zero_leaf(du_dx))
+        return du_dx;
 
-    if (!u || !du_dx)
+    node_t* u = copy_node(node -> right);
+    if (!u)
     {
-        free_nodes(2, u, du_dx);
+        free_nodes(1, du_dx);
         return NULL;
     }
 
-    node_t* cos_u = create_checked_unary_op(OP_COS, u);
+    node_t* cos_u = create_simplified_unary_op(OP_COS, u);
     if (!cos_u)
     {
         free_nodes(1, du_dx);
         return NULL;
     }
 
-    node_t* result = create_checked_op(OP_MUL, cos_u, du_dx);
+    node_t* result = create_simplified_op(OP_MUL, cos_u, du_dx);
     if (!result)
     {
         free_nodes(2, cos_u, du_dx);
@@ -466,18 +845,20 @@ static node_t* differentiate_sin(node_t* node, const char* variable_name)
 }
 
 
-static node_t* differentiate_cos(node_t* node, const char* variable_name)
+static node_t* differentiate_cos(node_t* node, differentiation_context* context)
 {
-    node_t* u = copy_node(node -> right);
-    node_t* du_dx = differentiate_node(node -> right, variable_name);
+    node_t* du_dx = differentiate_node(node -> right, context);
+    if (!du_dx || is_zero_leaf(du_dx))
+        return du_dx;
 
-    if (!u || !du_dx)
+    node_t* u = copy_node(node -> right);
+    if (!u)
     {
-        free_nodes(2, u, du_dx);
+        free_nodes(1, du_dx);
         return NULL;
     }
 
-    node_t* sin_u = create_checked_unary_op(OP_SIN, u);
+    node_t* sin_u = create_simplified_unary_op(OP_SIN, u);
     if (!sin_u)
     {
         free_nodes(1, du_dx);
@@ -491,14 +872,14 @@ static node_t* differentiate_cos(node_t* node, const char* variable_name)
         return NULL;
     }
 
-    node_t* minus_sin_u = create_checked_op(OP_MUL, minus_one, sin_u);
+    node_t* minus_sin_u = create_simplified_op(OP_MUL, minus_one, sin_u);
     if (!minus_sin_u)
     {
         free_nodes(3, minus_one, sin_u, du_dx);
         return NULL;
     }
 
-    node_t* result = create_checked_op(OP_MUL, minus_sin_u, du_dx);
+    node_t* result = create_simplified_op(OP_MUL, minus_sin_u, du_dx);
     if (!result)
         free_nodes(2, minus_sin_u, du_dx);
 
@@ -508,25 +889,41 @@ static node_t* differentiate_cos(node_t* node, const char* variable_name)
 
 static node_t* differentiate_power_var_const(node_t* u, node_t* v, node_t* du_dx, node_t* dv_dx)
 {
-    node_t* a_minus_one = CREATE_NUM(v -> data.num_value - 1.0);
+    // показатель - число или выражение без переменной дифференцирования
+    node_t* a_minus_one = NULL;
+    if (v -> type == NODE_NUM)
+    {
+        a_minus_one = CREATE_NUM(v -> data.num_value - 1.0);
+    }
+    else
+    {
+        node_t* v_copy = copy_node(v);
+        node_t* one    = CREATE_NUM(1.0);
+        // create_simplified_op сам освобождает операнды, если не смог построить узел
+        if (v_copy && one)
+            a_minus_one = create_simplified_op(OP_SUB, v_copy, one);
+        else
+            free_nodes(2, v_copy, one);
+    }
+
     if (!a_minus_one)
         return NULL;
 
-    node_t* u_pow_a_minus_one = create_checked_op(OP_POW, u, a_minus_one);
+    node_t* u_pow_a_minus_one = create_simplified_op(OP_POW, u, a_minus_one);
     if (!u_pow_a_minus_one)
     {
         free_nodes(1, a_minus_one);
         return NULL;
     }
 
-    node_t* a_times_pow = create_checked_op(OP_MUL, v, u_pow_a_minus_one);
+    node_t* a_times_pow = create_simplified_op(OP_MUL, v, u_pow_a_minus_one);
     if (!a_times_pow)
     {
         free_nodes(1, u_pow_a_minus_one);
         return NULL;
     }
 
-    node_t* result = create_checked_op(OP_MUL, a_times_pow, du_dx);
+    node_t* result = create_simplified_op(OP_MUL, a_times_pow, du_dx);
     if (!result)
         free_nodes(1, a_times_pow);
     else
@@ -538,7 +935,7 @@ static node_t* differentiate_power_var_const(node_t* u, node_t* v, node_t* du_dx
 
 static node_t* differentiate_power_const_var(node_t* u, node_t* v, node_t* du_dx, node_t* dv_dx)
 {
-    node_t* a_pow_x = create_checked_op(OP_POW, u, v);
+    node_t* a_pow_x = create_simplified_op(OP_POW, u, v);
     if (!a_pow_x)
         return NULL;
 
@@ -549,18 +946,25 @@ static node_t* differentiate_power_const_var(node_t* u, node_t* v, node_t* du_dx
         return NULL;
     }
 
-    node_t* ln_a = create_checked_unary_op(OP_LN, u_copy);
+    node_t* ln_a = create_simplified_unary_op(OP_LN, u_copy);
     if (!ln_a)
     {
         free_nodes(2, a_pow_x, u_copy);
         return NULL;
     }
 
-    node_t* result = create_checked_op(OP_MUL, a_pow_x, ln_a);
-    if (!result)
+    node_t* a_pow_x_ln_a = create_simplified_op(OP_MUL, a_pow_x, ln_a);
+    if (!a_pow_x_ln_a)
+    {
         free_nodes(2, a_pow_x, ln_a);
+        return NULL;
+    }
+
+    node_t* result = create_simplified_op(OP_MUL, a_pow_x_ln_a, dv_dx);
+    if (!result)
+        free_nodes(1, a_pow_x_ln_a);
     else
-        free_nodes(2, du_dx, dv_dx);
+        free_subtree(du_dx);
 
     return result;
 }
@@ -568,7 +972,7 @@ static node_t* differentiate_power_const_var(node_t* u, node_t* v, node_t* du_dx
 
 static node_t* differentiate_power_var_var(node_t* u, node_t* v, node_t* du_dx, node_t* dv_dx)
 {
-    node_t* u_pow_v = create_checked_op(OP_POW, u, v);
+    node_t* u_pow_v = create_simplified_op(OP_POW, u, v);
     if (!u_pow_v)
         return NULL;
 
@@ -582,42 +986,42 @@ static node_t* differentiate_power_var_var(node_t* u, node_t* v, node_t* du_dx,
         return NULL;
     }
 
-    node_t* ln_u = create_checked_unary_op(OP_LN, u_copy_for_ln);
+    node_t* ln_u = create_simplified_unary_op(OP_LN, u_copy_for_ln);
     if (!ln_u)
     {
         free_nodes(4, u_pow_v, u_copy_for_ln, u_copy_for_div, v_copy_for_div);
         return NULL;
     }
 
-    node_t* dv_ln_u = create_checked_op(OP_MUL, dv_dx, ln_u);
+    node_t* dv_ln_u = create_simplified_op(OP_MUL, dv_dx, ln_u);
     if (!dv_ln_u)
     {
         free_nodes(4, u_pow_v, u_copy_for_div, v_copy_for_div, ln_u);
         return NULL;
     }
 
-    node_t* v_div_u = create_checked_op(OP_DIV, v_copy_for_div, u_copy_for_div);
+    node_t* v_div_u = create_simplified_op(OP_DIV, v_copy_for_div, u_copy_for_div);
     if (!v_div_u)
     {
         free_nodes(3, u_pow_v, dv_ln_u, v_copy_for_div);
         return NULL;
     }
 
-    node_t* v_du_div_u = create_checked_op(OP_MUL, v_div_u, du_dx);
+    node_t* v_du_div_u = create_simplified_op(OP_MUL, v_div_u, du_dx);
     if (!v_du_div_u)
     {
         free_nodes(3, u_pow_v, dv_ln_u, v_div_u);
         return NULL;
     }
 
-    node_t* bracket = create_checked_op(OP_ADD, dv_ln_u, v_du_div_u);
+    node_t* bracket = create_simplified_op(OP_ADD, dv_ln_u, v_du_div_u);
     if (!bracket)
     {
         free_nodes(3, u_pow_v, dv_ln_u, v_du_div_u);
         return NULL;
     }
 
-    node_t* result = create_checked_op(OP_MUL, u_pow_v, bracket);
+    node_t* result = create_simplified_op(OP_MUL, u_pow_v, bracket);
     if (!result)
         free_nodes(2, u_pow_v, bracket);
 
@@ -625,27 +1029,40 @@ static node_t* differentiate_power_var_var(node_t* u, node_t* v, node_t* du_dx,
 }
 
 
-static node_t* differentiate_pow(node_t* node, const char* variable_name)
+static node_t* differentiate_pow(node_t* node, differentiation_context* context)
 {
+    node_t* du_dx = differentiate_node(node -> left,  context);
+    node_t* dv_dx = differentiate_node(node -> right, context);
+
+    if (!du_dx || !dv_dx)
+    {
+        free_nodes(2, du_dx, dv_dx);
+        return NULL;
+    }
+
+    bool is_base_constant     = is_zero_leaf(du_dx);
+    bool is_exponent_constant = is_zero_leaf(dv_dx);
+
+    if (is_base_constant && is_exponent_constant)
+    {
+        free_subtree(dv_dx);
+        return du_dx;
+    }
+
     node_t* u = copy_node(node -> left);
     node_t* v = copy_node(node -> right);
-    node_t* du_dx = differentiate_node(node -> left, variable_name);
-    node_t* dv_dx = differentiate_node(node -> right, variable_name);
 
-    if (!u || !v || !du_dx || !dv_dx)
+    if (!u || !v)
     {
         free_nodes(4, u, v, du_dx, dv_dx);
         return NULL;
     }
 
-    bool left_has_var  = contains_variable(node -> left, variable_name);
-    bool right_has_var = contains_variable(node -> right, variable_name);
-
     node_t* result = NULL;
 
-    if (left_has_var && !right_has_var)
+    if (is_exponent_constant)
         result = differentiate_power_var_const(u, v, du_dx, dv_dx);
-    else if (!left_has_var && right_has_var)
+    else if (is_base_constant)
         result = differentiate_power_const_var(u, v, du_dx, dv_dx);
     else
         result = differentiate_power_var_var(u, v, du_dx, dv_dx);
@@ -657,14 +1074,16 @@ static node_t* differentiate_pow(node_t* node, const char* variable_name)
 }
 
 
-static node_t* differentiate_ln(node_t* node, const char* variable_name)
+static node_t* differentiate_ln(node_t* node, differentiation_context* context)
 {
-    node_t* u = copy_node(node -> right);
-    node_t* du_dx = differentiate_node(node -> right, variable_name);
+    node_t* du_dx = differentiate_node(node -> right, context);
+    if (!du_dx || is_zero_leaf(du_dx))
+        return du_dx;
 
-    if (!u || !du_dx)
+    node_t* u = copy_node(node -> right);
+    if (!u)
     {
-        free_nodes(2, u, du_dx);
+        free_nodes(1, du_dx);
         return NULL;
     }
 
@@ -675,14 +1094,14 @@ static node_t* differentiate_ln(node_t* node, const char* variable_name)
         return NULL;
     }
 
-    node_t* one_div_u = create_checked_op(OP_DIV, one, u);
+    node_t* one_div_u = create_simplified_op(OP_DIV, one, u);
     if (!one_div_u)
     {
         free_nodes(3, one, u, du_dx);
         return NULL;
     }
 
-    node_t* result = create_checked_op(OP_MUL, one_div_u, du_dx);
+    node_t* result = create_simplified_op(OP_MUL, one_div_u, du_dx);
     if (!result)
         free_nodes(2, one_div_u, du_dx);
 
@@ -690,25 +1109,27 @@ static node_t* differentiate_ln(node_t* node, const char* variable_name)
 }
 
 
-static node_t* differentiate_exp(node_t* node, const char* variable_name)
+static node_t* differentiate_exp(node_t* node, differentiation_context* context)
 {
-    node_t* u = copy_node(node -> right);
-    node_t* du_dx = differentiate_node(node -> right, variable_name);
+    node_t* du_dx = differentiate_node(node -> right, context);
+    if (!du_dx || is_zero_leaf(du_dx))
+        return du_dx;
 
-    if (!u || !du_dx)
+    node_t* u = copy_node(node -> right);
+    if (!u)
     {
-        free_nodes(2, u, du_dx);
+        free_nodes(1, du_dx);
         return NULL;
     }
 
-    node_t* exp_u = create_checked_unary_op(OP_EXP, u);
+    node_t* exp_u = create_simplified_unary_op(OP_EXP, u);
     if (!exp_u)
     {
         free_nodes(1, du_dx);
         return NULL;
     }
 
-    node_t* result = create_checked_op(OP_MUL, exp_u, du_dx);
+    node_t* result = create_simplified_op(OP_MUL, exp_u, du_dx);
     if (!result)
         free_nodes(2, exp_u, du_dx);
 
@@ -716,11 +1137,8 @@ static node_t* differentiate_exp(node_t* node, const char* variable_name)
 }
 
 
-static node_t* differentiate_node(node_t* node, const char* variable_name)
+static node_t* apply_differentiation_rule(node_t* node, differentiation_context* context)
 {
-    if (node == NULL)
-        return NULL;
-
     switch (node -> type)
     {
         case NODE_NUM:
@@ -728,7 +1146,7 @@ static node_t* differentiate_node(node_t* node, const char* variable_name)
 
         case NODE_VAR:
             if (node -> data.var_definition.name &&
-                strcmp(node -> data.var_definition.name, variable_name) == 0)
+                strcmp(node -> data.var_definition.name, context -> variable_name) == 0)
             {
                 return CREATE_NUM(1.0);
             }
@@ -742,28 +1160,28 @@ static node_t* differentiate_node(node_t* node, const char* variable_name)
             {
                 case OP_ADD:
                 case OP_SUB:
-                    return differentiate_add_sub(node, variable_name, node -> data.op_value);
+                    return differentiate_add_sub(node, context, node -> data.op_value);
 
                 case OP_MUL:
-                    return differentiate_mul(node, variable_name);
+                    return differentiate_mul(node, context);
 
                 case OP_DIV:
-                    return differentiate_div(node, variable_name);
+                    return differentiate_div(node, context);
 
                 case OP_SIN:
-                    return differentiate_sin(node, variable_name);
+                    return differentiate_sin(node, context);
 
                 case OP_COS:
-                    return differentiate_cos(node, variable_name);
+                    return differentiate_cos(node, context);
 
                 case OP_POW:
-                    return differentiate_pow(node, variable_name);
+                    return differentiate_pow(node, context);
 
                 case OP_LN:
-                    return differentiate_ln(node, variable_name);
+                    return differentiate_ln(node, context);
 
                 case OP_EXP:
-                    return differentiate_exp(node, variable_name);
+                    return differentiate_exp(node, context);
 
                 default:
                     return CREATE_NUM(0.0);
@@ -775,6 +1193,274 @@ static node_t* differentiate_node(node_t* node, const char* variable_name)
 }
 
 
+static node_t* differentiate_node(node_t* node, differentiation_context* context)
+{
+    if (node == NULL)
+        return NULL;
+
+    // правила уже умеют освобождать построенное при NULL от differentiate_node
+    if (budget_exceeded(&context -> budget))
+    {
+        context -> failed = true;
+        return NULL;
+    }
+
+    node_t* derivative = apply_differentiation_rule(node, context);
+    if (derivative == NULL)
+        context -> failed = true;
+
+    return derivative;
+}
+
+
+// ==================== ПАРАЛЛЕЛЬНОЕ ДИФФЕРЕНЦИРОВАНИЕ ====================
+
+
+// Разобранная сумма - левая цепочка (((t1 + t2) + t3) + ...), поэтому развилка
+// на двух ветвях каждого + ничего не даёт. Все слагаемые цепочки собираются в массив
+// и делятся на куски не меньше DIFFERENTIATION_GRAIN_SIZE узлов, куски - задачи пула.
+// Задачи только дифференцируют слагаемые, сумму по исходному дереву собирает
+// combine_sum_derivatives, как и в последовательном обходе, поэтому деревья совпадают.
+// Узлы задача выделяет обычным calloc: malloc glibc держит отдельную арену на поток
+struct sum_term
+{
+    node_t* node;
+    node_t* derivative;
+};
+
+struct sum_chunk
+{
+    differentiation_context context;
+    sum_term*               terms;
+    size_t                  begin;
+    size_t                  end;
+};
+
+
+// Счёт останавливается на limit: цена не больше размера куска, даже для огромного поддерева
+static size_t count_nodes_up_to(node_t* node, size_t limit)
+{
+    if (node == NULL || limit == 0)
+        return 0;
+
+    size_t count = 1;
+    count += count_nodes_up_to(node -> left,  limit - count);
+    count += count_nodes_up_to(node -> right, limit - count);
+
+    return count;
+}
+
+
+static bool is_large_subtree(node_t* node)
+{
+    return count_nodes_up_to(node, DIFFERENTIATION_GRAIN_SIZE) >= DIFFERENTIATION_GRAIN_SIZE;
+}
+
+
+static bool is_sum_node(const node_t* node)
+{
+    return node -> type == NODE_OP && (node -> data.op_value == OP_ADD || node -> data.op_value == OP_SUB);
+}
+
+
+static bool reserve_terms(sum_term** terms, size_t* capacity, size_t needed)
+{
+    if (needed <= *capacity)
+        return true;
+
+    size_t    new_capacity = 2 * needed;
+    sum_term* new_terms    = (sum_term*)realloc(*terms, new_capacity * sizeof(sum_term));
+    if (new_terms == NULL)
+        return false;
+
+    *terms    = new_terms;
+    *capacity = new_capacity;
+    return true;
+}
+
+
+// Слагаемые в порядке слева направо
+static tree_error_type collect_sum_terms(node_t* root, sum_term** terms, size_t* number_of_terms)
+{
+    sum_term* stack          = NULL;
+    size_t    stack_size     = 0;
+    size_t    stack_capacity = 0;
+    size_t    terms_capacity = 0;
+
+    *terms           = NULL;
+    *number_of_terms = 0;
+
+    bool allocated = reserve_terms(&stack, &stack_capacity, 1);
+    if (allocated)
+        stack[stack_size++] = {root, NULL};
+
+    while (allocated && stack_size > 0)
+    {
+        sum_term top  = stack[--stack_size];
+        node_t*  node = top.node;
+
+        if (is_sum_node(node))
+        {
+            allocated = reserve_terms(&stack, &stack_capacity, stack_size + 2);
+            if (!allocated)
+                break;
+
+            // правое слагаемое кладётся первым, чтобы левое было снято раньше
+            stack[stack_size++] = {node -> right, NULL};
+            stack[stack_size++] = {node -> left,  NULL};
+        }
+        else
+        {
+            allocated = reserve_terms(terms, &terms_capacity, *number_of_terms + 1);
+            if (allocated)
+                (*terms)[(*number_of_terms)++] = top;
+        }
+    }
+
+    free(stack);
+
+    if (!allocated)
+    {
+        free(*terms);
+        *terms = NULL;
+        return TREE_ERROR_ALLOCATION;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+// Обход в порядке collect_sum_terms: производные слагаемых забираются по очереди
+static node_t* assemble_sum_derivative(node_t* node, sum_term* terms, size_t* next)
+{
+    if (!is_sum_node(node))
+    {
+        node_t* derivative = terms[*next].derivative;
+        terms[(*next)++].derivative = NULL;
+        return derivative;
+    }
+
+    node_t* left_deriv  = assemble_sum_derivative(node -> left,  terms, next);
+    node_t* right_deriv = assemble_sum_derivative(node -> right, terms, next);
+
+    return combine_sum_derivatives(node -> data.op_value, left_deriv, right_deriv);
+}
+
+
+static void differentiate_sum_chunk_task(void* argument)
+{
+    sum_chunk*    chunk  = (sum_chunk*)argument;
+    budget_state* budget = &chunk -> context.budget;
+
+    // created_nodes у каждого потока свой: отсчёт идёт от начала куска в выполняющем его потоке
+    budget -> nodes_at_start = created_nodes;
+    budget -> shared_local   = 0;
+
+    for (size_t i = chunk -> begin; i < chunk -> end && !chunk -> context.failed; i++)
+        chunk -> terms[i].derivative = differentiate_node(chunk -> terms[i].node, &chunk -> context);
+
+    budget_flush(budget);
+}
+
+
+static node_t* differentiate_sum_parallel(node_t* node, differentiation_context* context)
+{
+    sum_term* terms           = NULL;
+    size_t    number_of_terms = 0;
+
+    sum_chunk* chunks = NULL;
+    if (collect_sum_terms(node, &terms, &number_of_terms) == TREE_ERROR_NO)
+        chunks = (sum_chunk*)calloc(number_of_terms, sizeof(sum_chunk));
+
+    if (chunks == NULL)
+    {
+        free(terms);
+        context -> failed = true;
+        return NULL;
+    }
+
+    // куски тратят бюджет запуска через общий счётчик узлов
+    std::atomic<size_t> shared_nodes(0);
+    budget_share(&context -> budget, &shared_nodes);
+
+    size_t number_of_chunks = 0;
+    size_t chunk_nodes      = 0;
+
+    for (size_t i = 0; i < number_of_terms; i++)
+    {
+        if (chunk_nodes == 0)
+            chunks[number_of_chunks].begin = i;
+
+        chunk_nodes += count_nodes_up_to(terms[i].node, DIFFERENTIATION_GRAIN_SIZE);
+
+        if (chunk_nodes >= DIFFERENTIATION_GRAIN_SIZE || i + 1 == number_of_terms)
+        {
+            sum_chunk* chunk = &chunks[number_of_chunks++];
+            chunk -> end                   = i + 1;
+            chunk -> terms                 = terms;
+            chunk -> context.variable_name = context -> variable_name;
+            chunk -> context.pool          = context -> pool;
+            chunk -> context.forks_left    = context -> forks_left - 1;
+            chunk -> context.budget        = context -> budget;
+            chunk_nodes = 0;
+        }
+    }
+
+    task_group group = {};
+    task_group_init(&group);
+
+    // первый кусок считает текущий поток; задачу, которую не удалось поставить в очередь, тоже
+    for (size_t i = 1; i < number_of_chunks; i++)
+        if (thread_pool_submit(context -> pool, &group, differentiate_sum_chunk_task, &chunks[i]) != TREE_ERROR_NO)
+            differentiate_sum_chunk_task(&chunks[i]);
+
+    differentiate_sum_chunk_task(&chunks[0]);
+    task_group_wait(context -> pool, &group);
+
+    budget_collect(&context -> budget, &shared_nodes);
+
+    bool failed = false;
+    for (size_t i = 0; i < number_of_chunks; i++)
+    {
+        failed = failed || chunks[i].context.failed;
+        if (chunks[i].context.budget.exceeded)
+            context -> budget.exceeded = true;
+    }
+
+    node_t* sum = NULL;
+    if (!failed)
+    {
+        size_t next = 0;
+        sum = assemble_sum_derivative(node, terms, &next);
+    }
+
+    // после ошибки часть производных остаётся несобранной
+    for (size_t i = 0; i < number_of_terms; i++)
+        free_nodes(1, terms[i].derivative);
+
+    if (sum == NULL)
+        context -> failed = true;
+
+    free(chunks);
+    free(terms);
+
+    return sum;
+}
+
+
+static tree_error_type differentiate_root(tree_t* tree, tree_t* result_tree, differentiation_context* context)
+{
+    node_t* derivative_root = differentiate_node(tree -> root, context);
+    if (derivative_root == NULL)
+        return context -> budget.exceeded ? TREE_ERROR_BUDGET_EXCEEDED : TREE_ERROR_ALLOCATION;
+
+    result_tree -> root = derivative_root;
+    result_tree -> size = count_tree_nodes(derivative_root);
+
+    return TREE_ERROR_NO;
+}
+
+
 tree_error_type differentiate_tree(tree_t* tree, const char* variable_name, tree_t* result_tree)
 {
     if (tree == NULL || variable_name == NULL || result_tree == NULL)
@@ -783,14 +1469,47 @@ tree_error_type differentiate_tree(tree_t* tree, const char* variable_name, tree
     if (tree -> root == NULL)
         return TREE_ERROR_NULL_PTR;
 
-    node_t* derivative_root = differentiate_node(tree -> root, variable_name);
-    if (derivative_root == NULL)
-        return TREE_ERROR_ALLOCATION;
+    differentiation_context context = {};
+    context.variable_name = variable_name;
+    budget_start(&context.budget, NULL);
 
-    result_tree -> root = derivative_root;
-    result_tree -> size = count_tree_nodes(derivative_root);
+    return differentiate_root(tree, result_tree, &context);
+}
 
-    return TREE_ERROR_NO;
+
+tree_error_type differentiate_tree_with_budget(tree_t* tree, const char* variable_name, tree_t* result_tree,
+                                               const computation_budget* budget)
+{
+    if (tree == NULL || variable_name == NULL || result_tree == NULL || budget == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (tree -> root == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    differentiation_context context = {};
+    context.variable_name = variable_name;
+    budget_start(&context.budget, budget);
+
+    return differentiate_root(tree, result_tree, &context);
+}
+
+
+tree_error_type differentiate_tree_parallel(thread_pool* pool, tree_t* tree, const char* variable_name, tree_t* result_tree,
+                                            const computation_budget* budget)
+{
+    if (pool == NULL || tree == NULL || variable_name == NULL || result_tree == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (tree -> root == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    differentiation_context context = {};
+    context.variable_name = variable_name;
+    context.pool          = pool;
+    context.forks_left    = DIFFERENTIATION_FORK_DEPTH;
+    budget_start(&context.budget, budget);
+
+    return differentiate_root(tree, result_tree, &context);
 }
 
 
@@ -874,295 +1593,174 @@ static void replace_node(node_t** node_ptr, node_t* new_node)
 // ==================== ФУНКЦИИ ОПТИМИЗАЦИИ С ДАМПОМ ====================
 
 
-static tree_error_type constant_folding_optimization_with_dump(node_t** node, FILE* tex_file, tree_t* tree, variable_table* var_table)
+size_t count_tree_nodes(node_t* node)
 {
-    if (node == NULL || *node == NULL)
-        return TREE_ERROR_NULL_PTR;
+    if (node == NULL)
+        return 0;
 
-    tree_error_type error = TREE_ERROR_NO;
+    return 1 + count_tree_nodes(node -> left) + count_tree_nodes(node -> right);
+}
 
-    if ((*node) -> left != NULL)
-    {
-        error = constant_folding_optimization_with_dump(&(*node) -> left, tex_file, tree, var_table);
-        if (error != TREE_ERROR_NO)
-            return error;
-    }
 
-    if ((*node) -> right != NULL)
-    {
-        error = constant_folding_optimization_with_dump(&(*node) -> right, tex_file, tree, var_table);
-        if (error != TREE_ERROR_NO)
-            return error;
-    }
+// Правила из rewrite_rules смотрят только на узел и его детей.
+// Список работ обходит дерево снизу вверх: к обработке узла его дети уже упрощены,
+// а замена узла меняет лишь то, что видит родитель, который ещё лежит в списке
+// и будет обработан после. Поэтому хватает одного прохода вместо повторов до неподвижной точки
+struct rewrite_item
+{
+    node_t** slot;
+    bool     children_queued;
+};
 
-    if ((*node) -> type == NODE_OP)
-    {
-        if (((*node) -> data.op_value == OP_SIN || (*node) -> data.op_value == OP_COS ||
-             (*node) -> data.op_value == OP_LN  || (*node) -> data.op_value == OP_EXP) &&
-             (*node) -> right != NULL && (*node) -> right -> type == NODE_NUM)
-        {
-            double result = 0.0;
-            bool can_fold = true;
 
-            switch ((*node) -> data.op_value)
-            {
-                case OP_SIN:
-                    result = sin((*node) -> right -> data.num_value);
-                    break;
-                case OP_COS:
-                    result = cos((*node) -> right -> data.num_value);
-                    break;
-                case OP_LN:
-                    if ((*node) -> right -> data.num_value <= 0)
-                        can_fold = false;
-                    else
-                        result = log((*node) -> right -> data.num_value);
-                    break;
-                case OP_EXP:
-                    result = exp((*node) -> right -> data.num_value);
-                    break;
-                default:
-                    can_fold = false;
-                    break;
-            }
+// Ребёнок отцепляется от узла, чтобы replace_node не освободил его вместе со старым узлом
+static node_t* detach_child(node_t** child)
+{
+    node_t* kept = *child;
+    *child = NULL;
 
-            if (can_fold)
-            {
-                node_t* new_node = CREATE_NUM(result);
-                if (new_node != NULL)
-                {
-                    replace_node(node, new_node);
-
-                    double new_result = 0.0;
-                    if (evaluate_tree(tree, var_table, &new_result) == TREE_ERROR_NO && tex_file != NULL)
-                    {
-                        char description[MAX_TEX_DESCRIPTION_LENGTH] = {0};
-                        snprintf(description, sizeof(description),
-                                "constant folding simplified part of expression to: %.2f", result);
-                        dump_optimization_step_to_file(tex_file, description, tree, new_result);
-                    }
-                }
-            }
-        }
-        else if ((*node) -> left  != NULL && (*node) -> left -> type  == NODE_NUM &&
-                 (*node) -> right != NULL && (*node) -> right -> type == NODE_NUM)
+    return kept;
+}
+
+
+static node_t* apply_rewrite_rule(node_t* node, char* description, size_t description_size)
+{
+    const rewrite_rule* rule = match_rewrite_rule(node);
+    if (rule == NULL)
+        return NULL;
+
+    node_t* replacement = NULL;
+
+    switch (rule -> result)
+    {
+        case REWRITE_FOLD:
         {
-            double left_val  = (*node) -> left -> data.num_value;
-            double right_val = (*node) -> right -> data.num_value;
-            double result = 0.0;
-            bool can_fold = true;
+            double left_val = node -> left != NULL ? node -> left -> data.num_value : 0.0;
+            double result   = 0.0;
 
-            switch ((*node) -> data.op_value)
-            {
-                case OP_ADD:
-                    result = left_val + right_val;
-                    break;
-                case OP_SUB:
-                    result = left_val - right_val;
-                    break;
-                case OP_MUL:
-                    result = left_val * right_val;
-                    break;
-                case OP_DIV:
-                    if (is_zero(right_val))
-                        can_fold = false;
-                    else
-                        result = left_val / right_val;
-                    break;
-                default:
-                    can_fold = false;
-                    break;
-            }
+            if (!fold_numbers(node -> data.op_value, left_val, node -> right -> data.num_value, &result))
+                return NULL;
 
-            if (can_fold)
-            {
-                node_t* new_node = CREATE_NUM(result);
-                if (new_node != NULL)
-                {
-                    replace_node(node, new_node);
-
-                    double new_result = 0.0;
-                    if (evaluate_tree(tree, var_table, &new_result) == TREE_ERROR_NO && tex_file != NULL)
-                    {
-                        char description[MAX_TEX_DESCRIPTION_LENGTH] = {0};
-                        snprintf(description, sizeof(description),
-                                "constant folding simplified part of expression to: %.2f", result);
-                        dump_optimization_step_to_file(tex_file, description, tree, new_result);
-                    }
-                }
-            }
+            snprintf(description, description_size, "constant folding simplified part of expression to: %.2f", result);
+            return CREATE_NUM(result);
         }
+
+        case REWRITE_LEFT:  replacement = detach_child(&node -> left);  break;
+        case REWRITE_RIGHT: replacement = detach_child(&node -> right); break;
+        case REWRITE_ZERO:  replacement = CREATE_NUM(0.0);              break;
+        case REWRITE_ONE:   replacement = CREATE_NUM(1.0);              break;
+        default:
+            return NULL;
     }
 
-    return TREE_ERROR_NO;
+    snprintf(description, description_size, "%s", rule -> description);
+    return replacement;
+}
+
+
+static void rewrite_at(node_t** slot, FILE* tex_file, tree_t* tree, variable_table* var_table)
+{
+    char description[MAX_TEX_DESCRIPTION_LENGTH] = {};
+
+    // заменитель - число или уже упрощённый ребёнок, к нему правила больше не применимы
+    node_t* replacement = apply_rewrite_rule(*slot, description, sizeof(description));
+    if (replacement == NULL)
+        return;
+
+    replace_node(slot, replacement);
+
+    double new_result = 0.0;
+    if (tex_file != NULL && evaluate_tree(tree, var_table, &new_result) == TREE_ERROR_NO)
+        dump_optimization_step_to_file(tex_file, description, tree, new_result);
 }
 
 
-static tree_error_type neutral_elements_optimization_with_dump(node_t** node, FILE* tex_file, tree_t* tree, variable_table* var_table)
+static tree_error_type optimize_subtree_with_dump(node_t** node, FILE* tex_file, tree_t* tree, variable_table* var_table,
+                                                  budget_state* budget)
 {
     if (node == NULL || *node == NULL)
         return TREE_ERROR_NULL_PTR;
 
-    tree_error_type error = TREE_ERROR_NO;
+    size_t capacity = 64;
+    size_t size     = 0;
 
-    if ((*node) -> left != NULL)
-    {
-        error = neutral_elements_optimization_with_dump(&(*node) -> left, tex_file, tree, var_table);
-        if (error != TREE_ERROR_NO)
-            return error;
-    }
+    rewrite_item* worklist = (rewrite_item*)calloc(capacity, sizeof(rewrite_item));
+    if (worklist == NULL)
+        return TREE_ERROR_ALLOCATION;
 
-    if ((*node) -> right != NULL)
-    {
-        error = neutral_elements_optimization_with_dump(&(*node) -> right, tex_file, tree, var_table);
-        if (error != TREE_ERROR_NO)
-            return error;
-    }
+    worklist[size++] = {node, false};
+    tree_error_type error = TREE_ERROR_NO;
 
-    if ((*node) -> type == NODE_OP)
+    while (size > 0)
     {
-        node_t* new_node = NULL;
-        const char* description = NULL;
-
-        switch ((*node) -> data.op_value)
+        if (budget_exceeded(budget))
         {
-            case OP_ADD:
-                if ((*node) -> right != NULL && (*node) -> right -> type == NODE_NUM &&
-                    is_zero((*node) -> right -> data.num_value))
-                {
-                    new_node = copy_node((*node) -> left);
-                    description = "adding zero simplified";
-                }
-                else if ((*node) -> left != NULL && (*node) -> left -> type == NODE_NUM &&
-                         is_zero((*node) -> left -> data.num_value))
-                {
-                    new_node = copy_node((*node) -> right);
-                    description = "adding zero simplified";
-                }
-                break;
+            error = TREE_ERROR_BUDGET_EXCEEDED;
+            break;
+        }
 
-            case OP_SUB:
-                if ((*node) -> right != NULL && (*node) -> right -> type == NODE_NUM &&
-                    is_zero((*node) -> right -> data.num_value))
-                {
-                    new_node = copy_node((*node) -> left);
-                    description = "- 0 simplified";
-                }
-                break;
+        rewrite_item item    = worklist[size - 1];
+        node_t*      current = *item.slot;
 
-            case OP_MUL:
-                if (((*node) -> left != NULL && (*node) -> left -> type == NODE_NUM &&
-                     is_zero((*node) -> left -> data.num_value)) ||
-                    ((*node) -> right != NULL && (*node) -> right -> type == NODE_NUM &&
-                     is_zero((*node) -> right -> data.num_value)))
-                {
-                    new_node = CREATE_NUM(0.0);
-                    description = "mul zero simplified";
-                }
-                else if ((*node) -> right != NULL && (*node) -> right -> type == NODE_NUM &&
-                         is_one((*node) -> right -> data.num_value))
-                {
-                    new_node = copy_node((*node) -> left);
-                    description = "mul one simplified";
-                }
-                else if ((*node) -> left != NULL && (*node) -> left -> type == NODE_NUM &&
-                         is_one((*node) -> left -> data.num_value))
+        if (!item.children_queued && (current -> left != NULL || current -> right != NULL))
+        {
+            if (size + 2 > capacity)
+            {
+                rewrite_item* grown = (rewrite_item*)realloc(worklist, 2 * capacity * sizeof(rewrite_item));
+                if (grown == NULL)
                 {
-                    new_node = copy_node((*node) -> right);
-                    description = "mul one simplified";
+                    error = TREE_ERROR_ALLOCATION;
+                    break;
                 }
-                break;
 
-            case OP_DIV:
-                if ((*node) -> left != NULL && (*node) -> left -> type == NODE_NUM &&
-                    is_zero((*node) -> left -> data.num_value) &&
-                    (*node) -> right != NULL &&
-                    !((*node) -> right -> type == NODE_NUM && is_zero((*node) -> right -> data.num_value)))
-                {
-                    new_node = CREATE_NUM(0.0);
-                    description = "0 / simplified";
-                }
-                else if ((*node) -> right != NULL && (*node) -> right -> type == NODE_NUM &&
-                         is_one((*node) -> right -> data.num_value))
-                {
-                    new_node = copy_node((*node) -> left);
-                    description = " / 1 simplified";
-                }
-                break;
-            case OP_POW:
-                if ((*node) -> right != NULL && (*node) -> right -> type == NODE_NUM &&
-                    is_zero((*node) -> right -> data.num_value))
-                {
-                    new_node = CREATE_NUM(1.0);
-                    description = "^0 simplified";
-                }
-                else if ((*node) -> right != NULL && (*node) -> right -> type == NODE_NUM &&
-                         is_one((*node) -> right -> data.num_value))
-                {
-                    new_node = copy_node((*node) -> left);
-                    description = "^1 simplified";
-                }
-                else if ((*node) -> left != NULL && (*node) -> left -> type == NODE_NUM &&
-                         is_one((*node) -> left -> data.num_value))
-                {
-                    new_node = CREATE_NUM(1.0);
-                    description = "1^ simplified";
-                }
-                break;
-            default:
-                break;
-        }
+                worklist  = grown;
+                capacity *= 2;
+            }
 
-        if (new_node != NULL && description != NULL)
-        {
-            replace_node(node, new_node);
+            worklist[size - 1].children_queued = true;
 
-            double new_result = 0.0;
-            if (evaluate_tree(tree, var_table, &new_result) == TREE_ERROR_NO && tex_file != NULL)
-                dump_optimization_step_to_file(tex_file, description, tree, new_result);
+            // левое поддерево упрощается первым, как при рекурсивном обходе
+            if (current -> right != NULL) worklist[size++] = {&current -> right, false};
+            if (current -> left  != NULL) worklist[size++] = {&current -> left,  false};
+            continue;
         }
-    }
 
-    return TREE_ERROR_NO;
-}
+        size--;
+        rewrite_at(item.slot, tex_file, tree, var_table);
+    }
 
+    free(worklist);
 
-size_t count_tree_nodes(node_t* node)
-{
-    if (node == NULL)
-        return 0;
-
-    return 1 + count_tree_nodes(node -> left) + count_tree_nodes(node -> right);
+    return error;
 }
 
 
-static tree_error_type optimize_subtree_with_dump(node_t** node, FILE* tex_file, tree_t* tree, variable_table* var_table)
+static tree_error_type collect_like_terms_with_dump(tree_t* tree, FILE* tex_file, variable_table* var_table,
+                                                    budget_state* budget)
 {
-    if (node == NULL || *node == NULL)
-        return TREE_ERROR_NULL_PTR;
+    size_t size_before = count_tree_nodes(tree -> root);
 
-    size_t old_size = 0;
-    size_t new_size = count_tree_nodes(*node);
-    tree_error_type error = TREE_ERROR_NO;
-
-    do
-    {
-        old_size = new_size;
-
-        error = constant_folding_optimization_with_dump(node, tex_file, tree, var_table);
-        if (error != TREE_ERROR_NO) return error;
-
-        error = neutral_elements_optimization_with_dump(node, tex_file, tree, var_table);
-        if (error != TREE_ERROR_NO) return error;
+    tree_error_type error = collect_like_terms(tree, budget);
+    if (error != TREE_ERROR_NO)
+        return error;
 
-        new_size = count_tree_nodes(*node);
-    } while (new_size != old_size);
+    double new_result = 0.0;
+    if (tex_file != NULL && tree -> size != size_before && evaluate_tree(tree, var_table, &new_result) == TREE_ERROR_NO)
+        dump_optimization_step_to_file(tex_file, "like terms collected", tree, new_result);
 
     return TREE_ERROR_NO;
 }
 
 
 tree_error_type optimize_tree_with_dump(tree_t* tree, FILE* tex_file, variable_table* var_table)
+{
+    return optimize_tree_with_budget(tree, tex_file, var_table, NULL);
+}
+
+
+// При превышении бюджета дерево остаётся корректным, упрощённым лишь частично
+tree_error_type optimize_tree_with_budget(tree_t* tree, FILE* tex_file, variable_table* var_table,
+                                          const computation_budget* budget)
 {
     if (tree == NULL)
         return TREE_ERROR_NULL_PTR;
@@ -1185,8 +1783,16 @@ tree_error_type optimize_tree_with_dump(tree_t* tree, FILE* tex_file, variable_t
         // fprintf(tex_file, "Result before optimization: \\[ %.6f \\]\n\n", result_before);
     }
 
-    tree_error_type error = optimize_subtree_with_dump(&tree -> root, tex_file, tree, var_table);
-    if (error != TREE_ERROR_NO)
+    budget_state state = {};
+    budget_start(&state, budget);
+
+    tree_error_type error = optimize_subtree_with_dump(&tree -> root, tex_file, tree, var_table, &state);
+
+    // локальные правила уже убрали нейтральные элементы, подобные собираются по всему дереву
+    if (error == TREE_ERROR_NO)
+        error = collect_like_terms_with_dump(tree, tex_file, var_table, &state);
+
+    if (error != TREE_ERROR_NO && error != TREE_ERROR_BUDGET_EXCEEDED)
         return error;
 
     tree -> size = count_tree_nodes(tree -> root);
@@ -1205,7 +1811,7 @@ tree_error_type optimize_tree_with_dump(tree_t* tree, FILE* tex_file, variable_t
         fprintf(tex_file, "Final result: \\[ %.6f \\]\n\n", result_after);
     }
 
-    return TREE_ERROR_NO;
+    return error;
 }
 
 
@@ -1,9 +1,12 @@
 #ifndef OPERATIONS_H_
 #define OPERATIONS_H_
 
+#include <atomic>
+
 #include "tree_common.h"
 #include "variable_parse.h"
 #include "tree_error_types.h"
+#include "thread_pool.h"
 
 struct operator_mapping
 {
@@ -11,13 +14,58 @@ struct operator_mapping
     operation_type op_type;
 };
 
+// differentiate_tree_parallel отдаёт пулу куски сумм не меньше чем по DIFFERENTIATION_GRAIN_SIZE
+// узлов исходного дерева, суммы внутри слагаемых делятся не глубже DIFFERENTIATION_FORK_DEPTH.
+// Результат совпадает с differentiate_tree, бюджет общий для всех потоков запуска
+const size_t DIFFERENTIATION_GRAIN_SIZE = 4096;
+const size_t DIFFERENTIATION_FORK_DEPTH = 4;
+
+// Ограничения одного запуска differentiate_tree_with_budget или optimize_tree_with_budget:
+// число узлов, созданных за запуск, и время работы; 0 - без ограничения.
+// При превышении запуск прерывается с TREE_ERROR_BUDGET_EXCEEDED
+struct computation_budget
+{
+    size_t max_nodes;
+    double max_seconds;
+};
+
+const size_t DEFAULT_NODE_BUDGET         = 2000000;
+const double DEFAULT_TIME_BUDGET_SECONDS = 10.0;
+
+// Расход бюджета одного запуска: узлы считаются по созданным текущим потоком,
+// поэтому проходы, вызванные из запуска (collect_like_terms), тратят его же.
+// Потоки параллельного запуска складывают свои узлы в общий счётчик shared_nodes
+struct budget_state
+{
+    const computation_budget* budget;       // NULL - без ограничений
+    size_t                    nodes_at_start;
+    double                    start_time;
+    size_t                    checks;
+    bool                      exceeded;
+    std::atomic<size_t>*      shared_nodes; // NULL - запуск в одном потоке
+    size_t                    shared_local; // свои узлы, уже добавленные в shared_nodes
+};
+
+void budget_start   (budget_state* state, const computation_budget* budget);
+bool budget_exceeded(budget_state* state);
 void free_subtree(node_t* node);
 size_t count_tree_nodes(node_t* node);
+bool fold_numbers(operation_type op, double left_val, double right_val, double* result);
 tree_error_type evaluate_tree(tree_t* tree, variable_table* var_table, double* result);
 tree_error_type differentiate_tree(tree_t* tree, const char* variable_name, tree_t* result_tree);
+tree_error_type differentiate_tree_with_budget(tree_t* tree, const char* variable_name, tree_t* result_tree,
+                                               const computation_budget* budget);
+tree_error_type differentiate_tree_parallel(thread_pool* pool, tree_t* tree, const char* variable_name, tree_t* result_tree,
+                                            const computation_budget* budget);
 node_t* create_node(node_type type, value_of_tree_element data, node_t* left, node_t* right);
+node_t* create_num_node(double value);
+// Забирает left и right: если операнда нет или узел не выделился, оба освобождаются.
+// У унарной операции left == NULL
+node_t* create_checked_op(operation_type op, node_t* left, node_t* right);
 node_t* create_node_from_token(const char* token, node_t* parent);
 tree_error_type optimize_tree_with_dump(tree_t* tree, FILE* tex_file, variable_table* var_table);
+tree_error_type optimize_tree_with_budget(tree_t* tree, FILE* tex_file, variable_table* var_table,
+                                          const computation_budget* budget);
 
 
 #endif // OPERATIONS_H_
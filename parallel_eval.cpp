@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <thread>
+
+#include "batch_eval.h"
+#include "parallel_eval.h"
+
+// Общие для всех задач данные: выражение только читается,
+// у каждого потока пула свой буфер слотов, последний буфер - у отправившего потока
+struct parallel_batch
+{
+    thread_pool*                 pool;
+    std::thread::id              submitter;
+    const compiled_expression*   expr;
+    const double* const*         variables;
+    double*                      results;
+    point_error_mask*            errors;   // NULL - проверяемый режим
+    double**                     scratch;
+    std::atomic<int>             error;
+};
+
+struct batch_chunk
+{
+    parallel_batch* batch;
+    size_t          begin;
+    size_t          end;
+};
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static void evaluate_chunk_task(void* argument)
+{
+    batch_chunk*    chunk = (batch_chunk*)argument;
+    parallel_batch* batch = chunk -> batch;
+
+    if (batch -> error.load(std::memory_order_relaxed) != TREE_ERROR_NO)
+        return;
+
+    // чужой внешний поток, ожидающий свою группу, делит индекс с отправителем
+    // и потому считает во временном буфере
+    size_t  index     = thread_pool_worker_index(batch -> pool);
+    double* temporary = NULL;
+    double* scratch   = batch -> scratch[index];
+
+    if (index == thread_pool_size(batch -> pool) && std::this_thread::get_id() != batch -> submitter)
+    {
+        temporary = (double*)calloc(batch_scratch_size(batch -> expr), sizeof(double));
+        scratch   = temporary;
+    }
+
+    tree_error_type error = TREE_ERROR_ALLOCATION;
+
+    if (scratch != NULL && batch -> errors != NULL)
+        error = evaluate_batch_range_ieee(batch -> expr, batch -> variables, chunk -> begin, chunk -> end,
+                                          batch -> results, scratch, batch -> errors);
+    else if (scratch != NULL)
+        error = evaluate_batch_range(batch -> expr, batch -> variables, chunk -> begin, chunk -> end,
+                                     batch -> results, scratch);
+    free(temporary);
+
+    if (error != TREE_ERROR_NO)
+    {
+        int expected = TREE_ERROR_NO;
+        batch -> error.compare_exchange_strong(expected, error);
+    }
+}
+
+
+static void free_scratch_buffers(double** scratch, size_t number_of_buffers)
+{
+    if (scratch == NULL)
+        return;
+
+    for (size_t i = 0; i < number_of_buffers; i++)
+        free(scratch[i]);
+
+    free(scratch);
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+static tree_error_type run_batch_parallel(thread_pool* pool, const compiled_expression* expr,
+                                          const double* const* variables, size_t count, double* results,
+                                          point_error_mask* errors)
+{
+    if (pool == NULL || expr == NULL || results == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    size_t chunk_size        = PARALLEL_BLOCKS_PER_TASK * BATCH_BLOCK_SIZE;
+    size_t number_of_chunks  = (count + chunk_size - 1) / chunk_size;
+    size_t number_of_buffers = thread_pool_size(pool) + 1;
+
+    double**     scratch = (double**)    calloc(number_of_buffers, sizeof(double*));
+    batch_chunk* chunks  = (batch_chunk*)calloc(number_of_chunks + 1, sizeof(batch_chunk));
+
+    bool allocated = (scratch != NULL && chunks != NULL);
+    for (size_t i = 0; allocated && i < number_of_buffers; i++)
+    {
+        scratch[i] = (double*)calloc(batch_scratch_size(expr), sizeof(double));
+        allocated = (scratch[i] != NULL);
+    }
+
+    if (!allocated)
+    {
+        free_scratch_buffers(scratch, number_of_buffers);
+        free(chunks);
+        return TREE_ERROR_ALLOCATION;
+    }
+
+    parallel_batch batch = {};
+    batch.pool      = pool;
+    batch.submitter = std::this_thread::get_id();
+    batch.expr      = expr;
+    batch.variables = variables;
+    batch.results   = results;
+    batch.errors    = errors;
+    batch.scratch   = scratch;
+    batch.error.store(TREE_ERROR_NO);
+
+    task_group group = {};
+    task_group_init(&group);
+
+    for (size_t i = 0; i < number_of_chunks; i++)
+    {
+        chunks[i].batch = &batch;
+        chunks[i].begin = i * chunk_size;
+        chunks[i].end   = (chunks[i].begin + chunk_size < count) ? chunks[i].begin + chunk_size : count;
+
+        tree_error_type error = thread_pool_submit(pool, &group, evaluate_chunk_task, &chunks[i]);
+        if (error != TREE_ERROR_NO)
+        {
+            int expected = TREE_ERROR_NO;
+            batch.error.compare_exchange_strong(expected, error);
+            break;
+        }
+    }
+
+    task_group_wait(pool, &group);
+
+    free_scratch_buffers(scratch, number_of_buffers);
+    free(chunks);
+
+    return (tree_error_type)batch.error.load();
+}
+
+
+tree_error_type evaluate_batch_parallel(thread_pool* pool, const compiled_expression* expr,
+                                        const double* const* variables, size_t count, double* results)
+{
+    return run_batch_parallel(pool, expr, variables, count, results, NULL);
+}
+
+
+tree_error_type evaluate_batch_parallel_ieee(thread_pool* pool, const compiled_expression* expr,
+                                             const double* const* variables, size_t count, double* results,
+                                             point_error_mask* errors)
+{
+    if (errors == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    return run_batch_parallel(pool, expr, variables, count, results, errors);
+}
@@ -0,0 +1,19 @@
+#ifndef PARALLEL_EVAL_H_
+#define PARALLEL_EVAL_H_
+
+#include <stddef.h>
+
+#include "batch_eval.h"
+#include "thread_pool.h"
+#include "tree_error_types.h"
+#include "compiled_expression.h"
+
+const size_t PARALLEL_BLOCKS_PER_TASK = 16;
+
+tree_error_type evaluate_batch_parallel(thread_pool* pool, const compiled_expression* expr,
+                                        const double* const* variables, size_t count, double* results);
+tree_error_type evaluate_batch_parallel_ieee(thread_pool* pool, const compiled_expression* expr,
+                                             const double* const* variables, size_t count, double* results,
+                                             point_error_mask* errors);
+
+#endif // PARALLEL_EVAL_H_
@@ -0,0 +1,343 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "polynomial_form.h"
+#include "operations.h"
+#include "egraph.h"
+#include "logic_functions.h"
+
+// Коэффициенты при x^0 .. x^degree, старшие могут быть нулевыми;
+// variable == NULL - многочлен не зависит от переменной
+struct polynomial
+{
+    double      coefficients[MAX_POLYNOMIAL_DEGREE + 1];
+    int         degree;
+    const char* variable;   // имя из узла исходного дерева
+};
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static void constant_polynomial(polynomial* poly, double value)
+{
+    memset(poly, 0, sizeof(*poly));
+    poly -> coefficients[0] = value;
+}
+
+
+// Общая переменная двух многочленов; false, если переменные разные
+static bool common_variable(const polynomial* first, const polynomial* second, const char** variable)
+{
+    if (first -> variable == NULL || second -> variable == NULL || strcmp(first -> variable, second -> variable) == 0)
+    {
+        *variable = (first -> variable != NULL) ? first -> variable : second -> variable;
+        return true;
+    }
+
+    return false;
+}
+
+
+static bool add_polynomials(const polynomial* first, const polynomial* second, double sign, polynomial* result)
+{
+    polynomial sum = {};
+    if (!common_variable(first, second, &sum.variable))
+        return false;
+
+    sum.degree = (first -> degree > second -> degree) ? first -> degree : second -> degree;
+    for (int i = 0; i <= sum.degree; i++)
+        sum.coefficients[i] = first -> coefficients[i] + sign * second -> coefficients[i];
+
+    *result = sum;
+    return true;
+}
+
+
+static bool multiply_polynomials(const polynomial* first, const polynomial* second, polynomial* result)
+{
+    polynomial product = {};
+    if (!common_variable(first, second, &product.variable) || first -> degree + second -> degree > MAX_POLYNOMIAL_DEGREE)
+        return false;
+
+    product.degree = first -> degree + second -> degree;
+    for (int i = 0; i <= first -> degree; i++)
+        for (int j = 0; j <= second -> degree; j++)
+            product.coefficients[i + j] += first -> coefficients[i] * second -> coefficients[j];
+
+    *result = product;
+    return true;
+}
+
+
+static bool combine_polynomials(operation_type op, const polynomial* left, const polynomial* right, polynomial* result)
+{
+    switch (op)
+    {
+        case OP_ADD:
+            return add_polynomials(left, right,  1.0, result);
+
+        case OP_SUB:
+            return add_polynomials(left, right, -1.0, result);
+
+        case OP_MUL:
+            return multiply_polynomials(left, right, result);
+
+        case OP_DIV:
+        {
+            double divisor = right -> coefficients[0];
+            if (right -> variable != NULL || is_zero(divisor))
+                return false;
+
+            *result = *left;
+            for (int i = 0; i <= result -> degree; i++)
+                result -> coefficients[i] /= divisor;
+
+            return true;
+        }
+
+        case OP_POW:
+        {
+            double exponent = right -> coefficients[0];
+            if (right -> variable != NULL || !is_zero(exponent - round(exponent)) || exponent < 0.0 ||
+                exponent > MAX_POLYNOMIAL_DEGREE || left -> degree * (int)round(exponent) > MAX_POLYNOMIAL_DEGREE)
+                return false;
+
+            polynomial power = {};
+            constant_polynomial(&power, 1.0);
+
+            for (int i = 0; i < (int)round(exponent); i++)
+                multiply_polynomials(&power, left, &power);
+
+            *result = power;
+            return true;
+        }
+
+        case OP_SIN:
+        case OP_COS:
+        case OP_LN:
+        case OP_EXP:
+        default:
+            return false;
+    }
+}
+
+
+static node_t* create_variable(const char* name)
+{
+    value_of_tree_element data = {};
+    data.var_definition.name = strdup(name);
+    if (data.var_definition.name == NULL)
+        return NULL;
+
+    node_t* node = create_node(NODE_VAR, data, NULL, NULL);
+    if (node == NULL)
+        free(data.var_definition.name);
+
+    return node;
+}
+
+
+static bool is_number_one(const node_t* node)
+{
+    return node != NULL && node -> type == NODE_NUM && is_one(node -> data.num_value);
+}
+
+
+// x^exponent; степень двойки по схеме Эстрина строится повторным возведением в квадрат,
+// чтобы compile_tree вычислял x^2, x^4, ... один раз для всех половин
+static node_t* create_power(const char* variable, int exponent, bool squares)
+{
+    if (exponent == 1)
+        return create_variable(variable);
+
+    if (squares)
+    {
+        node_t* power = create_variable(variable);
+        for (int i = 1; i < exponent; i *= 2)
+            power = create_checked_op(OP_POW, power, create_num_node(2.0));
+
+        return power;
+    }
+
+    return create_checked_op(OP_POW, create_variable(variable), create_num_node((double)exponent));
+}
+
+
+// Забирает node
+static node_t* multiply_by_power(node_t* node, const char* variable, int exponent, bool squares)
+{
+    if (exponent == 0)
+        return node;
+
+    if (is_number_one(node))
+    {
+        free_subtree(node);
+        return create_power(variable, exponent, squares);
+    }
+
+    return create_checked_op(OP_MUL, node, create_power(variable, exponent, squares));
+}
+
+
+// Забирает node
+static node_t* add_constant(node_t* node, double value)
+{
+    if (is_zero(value))
+        return node;
+
+    if (value < 0.0)
+        return create_checked_op(OP_SUB, node, create_num_node(-value));
+
+    return create_checked_op(OP_ADD, node, create_num_node(value));
+}
+
+
+// ((a_n*x^(n-i) + a_i)*x^(i-j) + a_j)*... - нулевые коэффициенты пропускаются
+static node_t* build_horner(const polynomial* poly, int degree)
+{
+    node_t* result = create_num_node(poly -> coefficients[degree]);
+    int previous = degree;
+
+    for (int i = degree - 1; i >= 0; i--)
+    {
+        if (is_zero(poly -> coefficients[i]))
+            continue;
+
+        result   = multiply_by_power(result, poly -> variable, previous - i, false);
+        result   = add_constant(result, poly -> coefficients[i]);
+        previous = i;
+    }
+
+    return multiply_by_power(result, poly -> variable, previous, false);
+}
+
+
+// Коэффициенты begin..end: младшая половина + x^half * старшая, half - степень двойки
+static node_t* build_estrin(const polynomial* poly, int begin, int end)
+{
+    while (end > begin && is_zero(poly -> coefficients[end]))
+        end--;
+
+    if (end == begin)
+        return create_num_node(poly -> coefficients[begin]);
+
+    int half = 1;
+    while (2 * half < end - begin + 1)
+        half *= 2;
+
+    node_t* high = build_estrin(poly, begin + half, end);
+    high = multiply_by_power(high, poly -> variable, half, true);
+
+    node_t* low = build_estrin(poly, begin, begin + half - 1);
+    if (low != NULL && low -> type == NODE_NUM)
+    {
+        double constant = low -> data.num_value;
+        free_subtree(low);
+        return add_constant(high, constant);
+    }
+
+    return create_checked_op(OP_ADD, low, high);
+}
+
+
+static void replace_polynomial(node_t** slot, const polynomial* poly, polynomial_scheme scheme, tree_error_type* error)
+{
+    int degree = poly -> degree;
+    while (degree > 0 && is_zero(poly -> coefficients[degree]))
+        degree--;
+
+    // константы сворачивает optimize_tree_with_dump
+    if (poly -> variable == NULL || degree < 1)
+        return;
+
+    for (int i = 0; i <= degree; i++)
+        if (!isfinite(poly -> coefficients[i]))
+            return;
+
+    // решение принимается по схеме Горнера: в дереве Эстрина степени x^2, x^4, ... повторяются
+    // в каждой половине, а compile_tree вычисляет их один раз
+    node_t* rewritten = build_horner(poly, degree);
+    if (rewritten != NULL && evaluation_cost(rewritten) >= evaluation_cost(*slot))
+    {
+        free_subtree(rewritten);
+        return;
+    }
+
+    if (rewritten != NULL && scheme == POLYNOMIAL_ESTRIN)
+    {
+        free_subtree(rewritten);
+        rewritten = build_estrin(poly, 0, degree);
+    }
+
+    if (rewritten == NULL)
+    {
+        *error = TREE_ERROR_ALLOCATION;
+        return;
+    }
+
+    rewritten -> parent = (*slot) -> parent;
+    free_subtree(*slot);
+    *slot = rewritten;
+}
+
+
+// Возвращает true, если поддерево - многочлен (тогда он в poly и решение о замене
+// принимает родитель); иначе многочлены-дети уже заменены
+static bool rewrite_subtree(node_t** slot, polynomial_scheme scheme, polynomial* poly, tree_error_type* error)
+{
+    node_t* node = *slot;
+
+    switch (node -> type)
+    {
+        case NODE_NUM:
+            constant_polynomial(poly, node -> data.num_value);
+            return isfinite(node -> data.num_value);
+
+        case NODE_VAR:
+            constant_polynomial(poly, 0.0);
+            poly -> coefficients[1] = 1.0;
+            poly -> degree          = 1;
+            poly -> variable        = node -> data.var_definition.name;
+            return poly -> variable != NULL;
+
+        case NODE_OP:
+            break;
+
+        default:
+            return false;
+    }
+
+    polynomial left = {}, right = {};
+    bool left_is_polynomial  = node -> left  != NULL && rewrite_subtree(&node -> left,  scheme, &left,  error);
+    bool right_is_polynomial = node -> right != NULL && rewrite_subtree(&node -> right, scheme, &right, error);
+
+    if (left_is_polynomial && right_is_polynomial &&
+        combine_polynomials(node -> data.op_value, &left, &right, poly))
+        return true;
+
+    if (left_is_polynomial)
+        replace_polynomial(&node -> left,  &left,  scheme, error);
+    if (right_is_polynomial)
+        replace_polynomial(&node -> right, &right, scheme, error);
+
+    return false;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type rewrite_polynomials(tree_t* tree, polynomial_scheme scheme)
+{
+    if (tree == NULL || tree -> root == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    tree_error_type error = TREE_ERROR_NO;
+    polynomial poly = {};
+
+    if (rewrite_subtree(&tree -> root, scheme, &poly, &error))
+        replace_polynomial(&tree -> root, &poly, scheme, &error);
+
+    tree -> size = count_tree_nodes(tree -> root);
+
+    return error;
+}
@@ -0,0 +1,24 @@
+#ifndef POLYNOMIAL_FORM_H_
+#define POLYNOMIAL_FORM_H_
+
+#include "tree_common.h"
+#include "tree_error_types.h"
+
+// Наибольшие поддеревья, которые являются многочленом от одной переменной с числовыми
+// коэффициентами (+, -, *, деление на число, целая неотрицательная степень), переписываются
+// в схему Горнера ((a_n*x + a_{n-1})*x + ...)*x + a_0 - по умножению и сложению на степень
+// вместо pow на каждое слагаемое - или в схему Эстрина (a_0 + a_1*x) + x^2*(a_2 + a_3*x) + ...,
+// где половины вычисляются независимо. Пропуски в коэффициентах дают множитель x^k.
+// Поддерево заменяется, только если схема Горнера уменьшает его evaluation_cost.
+// Значение совпадает с исходным с точностью до округления
+const int MAX_POLYNOMIAL_DEGREE = 16;
+
+enum polynomial_scheme
+{
+    POLYNOMIAL_HORNER,
+    POLYNOMIAL_ESTRIN
+};
+
+tree_error_type rewrite_polynomials(tree_t* tree, polynomial_scheme scheme);
+
+#endif // POLYNOMIAL_FORM_H_
@@ -0,0 +1,52 @@
+#include <math.h>
+
+#include "power_reduction.h"
+
+bool is_reducible_exponent(double exponent)
+{
+    if (!(fabs(exponent) <= MAX_REDUCED_EXPONENT))
+        return false;
+
+    double doubled = 2.0 * exponent;
+
+    return !(doubled < floor(doubled) || doubled > floor(doubled));
+}
+
+
+double integer_power(double base, unsigned exponent)
+{
+    double result = 1.0;
+    double square = base;
+
+    while (exponent != 0)
+    {
+        if (exponent & 1u)
+            result *= square;
+
+        exponent >>= 1;
+        if (exponent != 0)
+            square *= square;
+    }
+
+    return result;
+}
+
+
+double reduced_pow(double base, double exponent)
+{
+    if (!is_reducible_exponent(exponent))
+        return pow(base, exponent);
+
+    double magnitude = fabs(exponent);
+    double whole     = floor(magnitude);
+
+    // сначала |показатель|, обратная величина в конце: так 0^(-0.5) = inf, как у pow()
+    double result = integer_power(base, (unsigned)whole);
+    if (magnitude > whole)
+        result *= sqrt(base);
+
+    if (exponent < 0)
+        result = 1.0 / result;
+
+    return result;
+}
@@ -0,0 +1,15 @@
+#ifndef POWER_REDUCTION_H_
+#define POWER_REDUCTION_H_
+
+#include <stdbool.h>
+
+// Показатели вида n и n + 0.5 при |n| <= MAX_REDUCED_EXPONENT считаются
+// умножениями (возведение в квадрат), sqrt и одним делением вместо pow().
+// Погрешность растёт с числом умножений: не больше ~|n| ulp против 1 ulp у pow()
+const int MAX_REDUCED_EXPONENT = 16;
+
+bool   is_reducible_exponent(double exponent);
+double integer_power        (double base, unsigned exponent);
+double reduced_pow          (double base, double exponent);
+
+#endif // POWER_REDUCTION_H_
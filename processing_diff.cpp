@@ -7,6 +7,7 @@
 #include "new_input.h"
 #include "latex_dump.h"
 #include "operations.h"
+#include "taylor_eval.h"
 #include "tree_common.h"
 #include "user_interface.h"
 #include "processing_diff.h"
@@ -20,6 +21,9 @@ differentiator_struct* create_differentiator_struct()
 
     tree_constructor(&diff_struct -> tree);
     init_variable_table(&diff_struct -> var_table);
+    diff_struct -> number_of_derivatives = DEFAULT_NUMBER_OF_DERIVATIVES;
+    diff_struct -> budget.max_nodes      = DEFAULT_NODE_BUDGET;
+    diff_struct -> budget.max_seconds    = DEFAULT_TIME_BUDGET_SECONDS;
 
     return diff_struct;
 }
@@ -48,6 +52,12 @@ tree_error_type initialize_expression(differentiator_struct* diff_struct, int ar
         return TREE_ERROR_NO_VARIABLES;
     }
 
+    tree_error_type error = get_number_of_derivatives(argc, argv, &diff_struct -> number_of_derivatives);
+    if (error != TREE_ERROR_NO)
+    {
+        return error;
+    }
+
     diff_struct -> expression = read_expression_from_file(input_file);
     if (!diff_struct -> expression)
     {
@@ -203,6 +213,33 @@ tree_error_type plot_function_graph(differentiator_struct* diff_struct)
     return TREE_ERROR_NO;
 }
 
+// Символьная форма порядка first_order не уложилась в бюджет: значения этого и
+// следующих порядков в точке считаются рядами Тейлора по исходному дереву
+static tree_error_type evaluate_remaining_derivatives(differentiator_struct* diff_struct, const char* diff_variable,
+                                                      int first_order)
+{
+    size_t  last_order  = (size_t)diff_struct -> number_of_derivatives;
+    double* derivatives = (double*)calloc(last_order + 1, sizeof(double));
+    if (!derivatives) return TREE_ERROR_ALLOCATION;
+
+    tree_error_type error = evaluate_taylor_tree(&diff_struct -> tree, &diff_struct -> var_table, diff_variable,
+                                                 last_order, derivatives);
+    if (error == TREE_ERROR_NO)
+    {
+        fprintf(diff_struct -> tex_file, "Derivatives from order %d exceed the node or time budget, "
+                                         "their values are computed numerically (Taylor mode).\n\n", first_order);
+
+        for (int order = first_order; order <= diff_struct -> number_of_derivatives; order++)
+        {
+            printf("Derivative %d: %.6f (Taylor mode)\n", order, derivatives[order]);
+            fprintf(diff_struct -> tex_file, "Derivative %d: \\[ %.6f \\]\n\n", order, derivatives[order]);
+        }
+    }
+
+    free(derivatives);
+    return error;
+}
+
 tree_error_type perform_differentiation_process(differentiator_struct* diff_struct)
 {
     if (!diff_struct || !diff_struct->tex_file) return TREE_ERROR_NULL_PTR;
@@ -218,46 +255,74 @@ tree_error_type perform_differentiation_process(differentiator_struct* diff_stru
 
     fprintf(diff_struct -> tex_file, "Differentiation variable: \\[ %s \\]\n\n", diff_variable);
 
-    tree_t derivative_trees[MAX_NUMBER_OF_DERIVATIVE]   = {};
-    double derivative_results[MAX_NUMBER_OF_DERIVATIVE] = {};
-    int actual_derivative_count = 0;
+    // в памяти только производная порядка k - 1 и строящаяся производная порядка k
+    tree_t derivative_trees[2] = {};
+    tree_constructor(&derivative_trees[0]);
+    tree_constructor(&derivative_trees[1]);
 
-    tree_t* current_tree = &diff_struct -> tree;
+    tree_t* previous_tree = &diff_struct -> tree;
+    tree_error_type error = TREE_ERROR_NO;
 
-    for (int i = 0; i < MAX_NUMBER_OF_DERIVATIVE; i++)
+    for (int order = 1; order <= diff_struct -> number_of_derivatives; order++)
     {
-        tree_constructor(&derivative_trees[i]);
+        tree_t* current_tree = &derivative_trees[order % 2];
+
+        error = differentiate_tree_with_budget(previous_tree, diff_variable, current_tree, &diff_struct -> budget);
+        if (error == TREE_ERROR_BUDGET_EXCEEDED)
+        {
+            error = evaluate_remaining_derivatives(diff_struct, diff_variable, order);
+            break;
+        }
 
-        tree_error_type error = differentiate_tree(current_tree, diff_variable, &derivative_trees[i]);
         if (error != TREE_ERROR_NO)
         {
-            tree_destructor(&derivative_trees[i]);
+            fprintf(stderr, "Failed to compute derivative %d: %s\n", order, tree_error_translator(error));
+            fprintf(diff_struct -> tex_file, "Failed to compute derivative %d: %s\n\n", order, tree_error_translator(error));
             break;
         }
 
-        fprintf(diff_struct -> tex_file, "\\subsection*{Optimization of derivative %d}\n", i + 1);
-        error = optimize_tree_with_dump(&derivative_trees[i], diff_struct -> tex_file, &diff_struct -> var_table);
+        if (previous_tree != &diff_struct -> tree)
+            tree_destructor(previous_tree);
 
-        error = evaluate_tree(&derivative_trees[i], &diff_struct -> var_table, &derivative_results[i]);
-        if (error == TREE_ERROR_NO)
+        fprintf(diff_struct -> tex_file, "\\subsection*{Optimization of derivative %d}\n", order);
+        // недооптимизированное дерево остаётся верным, цепочка продолжается с ним
+        error = optimize_tree_with_budget(current_tree, diff_struct -> tex_file, &diff_struct -> var_table,
+                                          &diff_struct -> budget);
+        if (error == TREE_ERROR_BUDGET_EXCEEDED)
+        {
+            printf("Optimization of derivative %d stopped: %s\n", order, tree_error_translator(error));
+            error = TREE_ERROR_NO;
+        }
+
+        if (error != TREE_ERROR_NO)
         {
-            printf("Derivative %d: %.6f\n", i + 1, derivative_results[i]);
-            actual_derivative_count++;
+            fprintf(stderr, "Failed to optimize derivative %d: %s\n", order, tree_error_translator(error));
+            break;
+        }
+
+        double derivative_result = 0.0;
 
-            dump_derivative_to_file(diff_struct -> tex_file, &derivative_trees[i], derivative_results[i], i + 1);
+        // значение может не существовать в точке (деление на ноль), следующие порядки всё равно строятся
+        tree_error_type evaluation_error = evaluate_tree(current_tree, &diff_struct -> var_table, &derivative_result);
+        if (evaluation_error == TREE_ERROR_NO)
+        {
+            printf("Derivative %d: %.6f\n", order, derivative_result);
+            dump_derivative_to_file(diff_struct -> tex_file, current_tree, derivative_result, order);
+        }
+        else
+        {
+            printf("Derivative %d: %s\n", order, tree_error_translator(evaluation_error));
         }
 
-        current_tree = &derivative_trees[i];
+        previous_tree = current_tree;
     }
 
     free(diff_variable);
 
-    for (int i = 0; i < actual_derivative_count; i++)
-    {
-        tree_destructor(&derivative_trees[i]);
-    }
+    tree_destructor(&derivative_trees[0]);
+    tree_destructor(&derivative_trees[1]);
 
-    return TREE_ERROR_NO;
+    return error;
 }
 
 tree_error_type finalize_latex_output(differentiator_struct* diff_struct)
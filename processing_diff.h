@@ -4,6 +4,7 @@
 #include <stdio.h>
 
 #include "tree_base.h"
+#include "operations.h"
 #include "variable_parse.h"
 #include "tree_error_types.h"
 
@@ -14,6 +15,8 @@ struct differentiator_struct
     char* expression;
     FILE* tex_file;
     double result;
+    int number_of_derivatives;
+    computation_budget budget;   // на построение и на оптимизацию каждой производной
 };
 
 differentiator_struct* create_differentiator_struct();
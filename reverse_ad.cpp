@@ -0,0 +1,193 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "reverse_ad.h"
+#include "logic_functions.h"
+#include "power_reduction.h"
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static void propagate_adjoint(const gradient_tape* tape, size_t index, double* gradient)
+{
+    const instruction_t* instruction = &tape -> program.instructions[index];
+
+    double adjoint = tape -> adjoints[index];
+    double value   = tape -> slots[index];
+    double left    = (instruction -> left  != NO_OPERAND) ? tape -> slots[instruction -> left]  : 0.0;
+    double right   = (instruction -> right != NO_OPERAND) ? tape -> slots[instruction -> right] : 0.0;
+
+    double* left_adjoint  = (instruction -> left  != NO_OPERAND) ? &tape -> adjoints[instruction -> left]  : NULL;
+    double* right_adjoint = (instruction -> right != NO_OPERAND) ? &tape -> adjoints[instruction -> right] : NULL;
+
+    switch (instruction -> code)
+    {
+        case INSTR_NUM:
+            break;
+        case INSTR_VAR:
+            gradient[instruction -> variable] += adjoint;
+            break;
+        case INSTR_ADD:
+            *left_adjoint  += adjoint;
+            *right_adjoint += adjoint;
+            break;
+        case INSTR_SUB:
+            *left_adjoint  += adjoint;
+            *right_adjoint -= adjoint;
+            break;
+        case INSTR_MUL:
+            *left_adjoint  += adjoint * right;
+            *right_adjoint += adjoint * left;
+            break;
+        case INSTR_DIV:
+            *left_adjoint  += adjoint / right;
+            *right_adjoint -= adjoint * value / right;
+            break;
+        case INSTR_SIN:
+            *right_adjoint += adjoint * cos(right);
+            break;
+        case INSTR_COS:
+            *right_adjoint -= adjoint * sin(right);
+            break;
+        case INSTR_POW:
+            *left_adjoint += adjoint * right * pow(left, right - 1.0);
+            if (left > 0)
+                *right_adjoint += adjoint * value * log(left);
+            break;
+        case INSTR_POWI:
+            // показатель - константа, его слот производной не получает
+            if (!is_zero(instruction -> value))
+                *left_adjoint += adjoint * instruction -> value * reduced_pow(left, instruction -> value - 1.0);
+            break;
+        case INSTR_LN:
+            *right_adjoint += adjoint / right;
+            break;
+        case INSTR_EXP:
+            *right_adjoint += adjoint * value;
+            break;
+        default:
+            break;
+    }
+}
+
+
+static tree_error_type load_variable_values(const compiled_expression* program, variable_table* var_table,
+                                            double* values)
+{
+    if (var_table -> number_of_variables < program -> number_of_variables)
+        return TREE_ERROR_VARIABLE_TABLE;
+
+    for (int i = 0; i < program -> number_of_variables; i++)
+    {
+        if (!var_table -> variables[i].is_defined)
+            return TREE_ERROR_VARIABLE_UNDEFINED;
+
+        values[i] = var_table -> variables[i].value;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type gradient_tape_constructor(gradient_tape* tape)
+{
+    if (tape == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    tape -> slots    = NULL;
+    tape -> adjoints = NULL;
+
+    return compiled_expression_constructor(&tape -> program);
+}
+
+
+tree_error_type gradient_tape_destructor(gradient_tape* tape)
+{
+    if (tape == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    compiled_expression_destructor(&tape -> program);
+    free(tape -> slots);
+    free(tape -> adjoints);
+
+    return gradient_tape_constructor(tape);
+}
+
+
+tree_error_type record_gradient_tape(tree_t* tree, variable_table* var_table, gradient_tape* tape)
+{
+    if (tree == NULL || var_table == NULL || tape == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    gradient_tape_destructor(tape);
+
+    tree_error_type error = compile_tree(tree, var_table, &tape -> program);
+    if (error != TREE_ERROR_NO)
+        return error;
+
+    tape -> slots    = (double*)calloc(tape -> program.size + 1, sizeof(double));
+    tape -> adjoints = (double*)calloc(tape -> program.size + 1, sizeof(double));
+
+    if (tape -> slots == NULL || tape -> adjoints == NULL)
+    {
+        gradient_tape_destructor(tape);
+        return TREE_ERROR_ALLOCATION;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+tree_error_type evaluate_gradient(gradient_tape* tape, const double* variables, double* value, double* gradient)
+{
+    if (tape == NULL || value == NULL || gradient == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (tape -> slots == NULL || tape -> adjoints == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    tree_error_type error = evaluate_compiled(&tape -> program, variables, tape -> slots, value);
+    if (error != TREE_ERROR_NO)
+        return error;
+
+    memset(tape -> adjoints, 0, tape -> program.size * sizeof(double));
+    memset(gradient, 0, (size_t)tape -> program.number_of_variables * sizeof(double));
+
+    tape -> adjoints[tape -> program.result] = 1.0;
+
+    // инструкции записаны в топологическом порядке, поэтому обратный обход
+    // доходит до узла только после всех его потребителей
+    for (size_t i = tape -> program.size; i-- > 0; )
+        propagate_adjoint(tape, i, gradient);
+
+    return TREE_ERROR_NO;
+}
+
+
+tree_error_type compute_gradient(tree_t* tree, variable_table* var_table, double* value, double* gradient)
+{
+    if (tree == NULL || var_table == NULL || value == NULL || gradient == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    gradient_tape tape = {};
+    gradient_tape_constructor(&tape);
+
+    double* values = (double*)calloc((size_t)var_table -> number_of_variables + 1, sizeof(double));
+    if (values == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    tree_error_type error = record_gradient_tape(tree, var_table, &tape);
+
+    if (error == TREE_ERROR_NO)
+        error = load_variable_values(&tape.program, var_table, values);
+
+    if (error == TREE_ERROR_NO)
+        error = evaluate_gradient(&tape, values, value, gradient);
+
+    free(values);
+    gradient_tape_destructor(&tape);
+
+    return error;
+}
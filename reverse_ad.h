@@ -0,0 +1,31 @@
+#ifndef REVERSE_AD_H_
+#define REVERSE_AD_H_
+
+#include <stddef.h>
+
+#include "tree_common.h"
+#include "variable_parse.h"
+#include "tree_error_types.h"
+#include "compiled_expression.h"
+
+// Лента обратного режима: программа дерева, значения всех узлов после прямого
+// прохода и сопряжённые (adjoint) значения. Один обратный проход даёт частные
+// производные по всем переменным variable_table за O(размер дерева)
+struct gradient_tape
+{
+    compiled_expression program;
+    double*             slots;
+    double*             adjoints;
+};
+
+tree_error_type gradient_tape_constructor(gradient_tape* tape);
+tree_error_type gradient_tape_destructor (gradient_tape* tape);
+tree_error_type record_gradient_tape     (tree_t* tree, variable_table* var_table, gradient_tape* tape);
+
+// gradient - массив на program.number_of_variables элементов
+tree_error_type evaluate_gradient        (gradient_tape* tape, const double* variables,
+                                          double* value, double* gradient);
+tree_error_type compute_gradient         (tree_t* tree, variable_table* var_table,
+                                          double* value, double* gradient);
+
+#endif // REVERSE_AD_H_
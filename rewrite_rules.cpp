@@ -0,0 +1,88 @@
+#include <stddef.h>
+
+#include "rewrite_rules.h"
+#include "logic_functions.h"
+
+// ==================== ТАБЛИЦА ПРАВИЛ ====================
+
+// Порядок важен: свёртка чисел раньше нейтральных элементов
+static const rewrite_rule REWRITE_RULES[] =
+{
+    {OP_SIN, PATTERN_NONE, PATTERN_NUM,      REWRITE_FOLD,  NULL},
+    {OP_COS, PATTERN_NONE, PATTERN_NUM,      REWRITE_FOLD,  NULL},
+    {OP_EXP, PATTERN_NONE, PATTERN_NUM,      REWRITE_FOLD,  NULL},
+    {OP_LN,  PATTERN_NONE, PATTERN_POSITIVE, REWRITE_FOLD,  NULL},
+    {OP_ADD, PATTERN_NUM,  PATTERN_NUM,      REWRITE_FOLD,  NULL},
+    {OP_SUB, PATTERN_NUM,  PATTERN_NUM,      REWRITE_FOLD,  NULL},
+    {OP_MUL, PATTERN_NUM,  PATTERN_NUM,      REWRITE_FOLD,  NULL},
+    {OP_DIV, PATTERN_NUM,  PATTERN_NONZERO,  REWRITE_FOLD,  NULL},
+
+    {OP_ADD, PATTERN_ANY,  PATTERN_ZERO,     REWRITE_LEFT,  "adding zero simplified"},
+    {OP_ADD, PATTERN_ZERO, PATTERN_ANY,      REWRITE_RIGHT, "adding zero simplified"},
+    {OP_SUB, PATTERN_ANY,  PATTERN_ZERO,     REWRITE_LEFT,  "- 0 simplified"},
+    {OP_MUL, PATTERN_ZERO, PATTERN_ANY,      REWRITE_ZERO,  "mul zero simplified"},
+    {OP_MUL, PATTERN_ANY,  PATTERN_ZERO,     REWRITE_ZERO,  "mul zero simplified"},
+    {OP_MUL, PATTERN_ANY,  PATTERN_ONE,      REWRITE_LEFT,  "mul one simplified"},
+    {OP_MUL, PATTERN_ONE,  PATTERN_ANY,      REWRITE_RIGHT, "mul one simplified"},
+    {OP_DIV, PATTERN_ZERO, PATTERN_ANY & ~PATTERN_ZERO, REWRITE_ZERO, "0 / simplified"},
+    {OP_DIV, PATTERN_ANY,  PATTERN_ONE,      REWRITE_LEFT,  " / 1 simplified"},
+    {OP_POW, PATTERN_ANY,  PATTERN_ZERO,     REWRITE_ONE,   "^0 simplified"},
+    {OP_POW, PATTERN_ANY,  PATTERN_ONE,      REWRITE_LEFT,  "^1 simplified"},
+    {OP_POW, PATTERN_ONE,  PATTERN_ANY,      REWRITE_ONE,   "1^ simplified"},
+};
+
+const size_t NUMBER_OF_OPERATIONS = (size_t)OP_EXP + 1;
+
+struct rewrite_decision_table
+{
+    const rewrite_rule* rules[NUMBER_OF_OPERATIONS][NUMBER_OF_OPERAND_CLASSES][NUMBER_OF_OPERAND_CLASSES];
+};
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static operand_class classify_operand(const node_t* operand)
+{
+    if (operand == NULL)
+        return OPERAND_NONE;
+
+    if (operand -> type != NODE_NUM)
+        return OPERAND_EXPR;
+
+    double value = operand -> data.num_value;
+
+    if (is_zero(value)) return OPERAND_ZERO;
+    if (is_one(value))  return OPERAND_ONE;
+
+    return value > 0 ? OPERAND_POSITIVE : OPERAND_NEGATIVE;
+}
+
+
+static rewrite_decision_table compile_rewrite_rules()
+{
+    rewrite_decision_table table = {};
+
+    // правила перебираются с конца, чтобы в клетке осталось первое подходящее
+    for (size_t i = sizeof(REWRITE_RULES) / sizeof(REWRITE_RULES[0]); i-- > 0; )
+    {
+        const rewrite_rule* rule = &REWRITE_RULES[i];
+
+        for (size_t left = 0; left < NUMBER_OF_OPERAND_CLASSES; left++)
+            for (size_t right = 0; right < NUMBER_OF_OPERAND_CLASSES; right++)
+                if ((rule -> left & 1u << left) && (rule -> right & 1u << right))
+                    table.rules[rule -> op][left][right] = rule;
+    }
+
+    return table;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+const rewrite_rule* match_rewrite_rule(const node_t* node)
+{
+    static const rewrite_decision_table table = compile_rewrite_rules();
+
+    if (node == NULL || node -> type != NODE_OP || (size_t)node -> data.op_value >= NUMBER_OF_OPERATIONS)
+        return NULL;
+
+    return table.rules[node -> data.op_value][classify_operand(node -> left)][classify_operand(node -> right)];
+}
@@ -0,0 +1,50 @@
+#ifndef REWRITE_RULES_H_
+#define REWRITE_RULES_H_
+
+#include "tree_common.h"
+
+// Классы операнда, по которым таблица выбирает правило
+enum operand_class
+{
+    OPERAND_NONE,      // нет операнда (левый у унарной операции)
+    OPERAND_EXPR,      // переменная или операция
+    OPERAND_ZERO,
+    OPERAND_ONE,
+    OPERAND_POSITIVE,  // число > 0, кроме 1
+    OPERAND_NEGATIVE,
+    NUMBER_OF_OPERAND_CLASSES
+};
+
+// Образец операнда - множество допустимых классов
+const unsigned PATTERN_NONE     = 1u << OPERAND_NONE;
+const unsigned PATTERN_ZERO     = 1u << OPERAND_ZERO;
+const unsigned PATTERN_ONE      = 1u << OPERAND_ONE;
+const unsigned PATTERN_POSITIVE = PATTERN_ONE | 1u << OPERAND_POSITIVE;
+const unsigned PATTERN_NONZERO  = PATTERN_POSITIVE | 1u << OPERAND_NEGATIVE;
+const unsigned PATTERN_NUM      = PATTERN_ZERO | PATTERN_NONZERO;
+const unsigned PATTERN_ANY      = PATTERN_NUM | 1u << OPERAND_EXPR;
+
+enum rewrite_result
+{
+    REWRITE_FOLD,   // число - значение операции над числами-операндами
+    REWRITE_LEFT,   // левый операнд
+    REWRITE_RIGHT,  // правый операнд
+    REWRITE_ZERO,
+    REWRITE_ONE
+};
+
+struct rewrite_rule
+{
+    operation_type op;
+    unsigned       left;
+    unsigned       right;
+    rewrite_result result;
+    const char*    description;
+};
+
+// Правила задаются таблицей и при первом обращении раскладываются в таблицу решений
+// [операция][класс левого][класс правого]: поиск правила для узла - два классификатора
+// и одно обращение к массиву. Из подходящих правил выбирается первое по порядку таблицы
+const rewrite_rule* match_rewrite_rule(const node_t* node);
+
+#endif // REWRITE_RULES_H_
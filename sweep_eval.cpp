@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include "sweep_eval.h"
+#include "batch_eval.h"
+#include "incremental_eval.h"
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static tree_error_type load_invariant_values(const compiled_expression* expr, variable_table* var_table,
+                                             int sweep_variable, double* values)
+{
+    for (int i = 0; i < expr -> number_of_variables; i++)
+    {
+        if (i == sweep_variable)
+            continue;
+
+        if (!var_table -> variables[i].is_defined)
+            return TREE_ERROR_VARIABLE_UNDEFINED;
+
+        values[i] = var_table -> variables[i].value;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+static tree_error_type build_residual(const compiled_expression* expr, const variable_mask* dependencies,
+                                      variable_mask sweep_mask, const double* slots, sweep_expression* sweep)
+{
+    int* remap = (int*)calloc(expr -> size + 1, sizeof(int));
+    instruction_t* instructions = (instruction_t*)calloc(expr -> size + 1, sizeof(instruction_t));
+
+    if (remap == NULL || instructions == NULL)
+    {
+        free(remap);
+        free(instructions);
+        return TREE_ERROR_ALLOCATION;
+    }
+
+    for (size_t i = 0; i < expr -> size; i++)
+        remap[i] = NO_OPERAND;
+
+    size_t size = 0;
+
+    // инвариантный операнд зависимой инструкции превращается в константу
+    for (size_t i = 0; i < expr -> size; i++)
+    {
+        const instruction_t* instruction = &expr -> instructions[i];
+        if ((dependencies[i] & sweep_mask) == 0)
+            continue;
+
+        int operands[2] = {instruction -> left, instruction -> right};
+        for (size_t j = 0; j < 2; j++)
+        {
+            int operand = operands[j];
+            if (operand == NO_OPERAND || remap[operand] != NO_OPERAND)
+                continue;
+
+            instruction_t constant = {INSTR_NUM, NO_OPERAND, NO_OPERAND, NO_OPERAND, slots[operand]};
+            instructions[size] = constant;
+            remap[operand] = (int)size++;
+        }
+
+        instruction_t copy = *instruction;
+        if (copy.left  != NO_OPERAND) copy.left  = remap[copy.left];
+        if (copy.right != NO_OPERAND) copy.right = remap[copy.right];
+        if (copy.code  == INSTR_VAR)  copy.variable = 0;
+
+        instructions[size] = copy;
+        remap[i] = (int)size++;
+    }
+
+    int result = remap[expr -> result];
+    if (result == NO_OPERAND)
+    {
+        instruction_t constant = {INSTR_NUM, NO_OPERAND, NO_OPERAND, NO_OPERAND, slots[expr -> result]};
+        instructions[size] = constant;
+        result = (int)size++;
+    }
+
+    sweep -> residual.instructions        = instructions;
+    sweep -> residual.size                = size;
+    sweep -> residual.capacity            = expr -> size + 1;
+    sweep -> residual.result              = result;
+    sweep -> residual.number_of_variables = 1;
+    sweep -> hoisted_instructions         = expr -> size - size;
+
+    free(remap);
+    return TREE_ERROR_NO;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type sweep_expression_constructor(sweep_expression* sweep)
+{
+    if (sweep == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    sweep -> sweep_variable       = NO_OPERAND;
+    sweep -> hoisted_instructions = 0;
+
+    return compiled_expression_constructor(&sweep -> residual);
+}
+
+
+tree_error_type sweep_expression_destructor(sweep_expression* sweep)
+{
+    if (sweep == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    compiled_expression_destructor(&sweep -> residual);
+
+    return sweep_expression_constructor(sweep);
+}
+
+
+tree_error_type prepare_sweep(const compiled_expression* expr, variable_table* var_table,
+                              const char* sweep_variable, sweep_expression* sweep)
+{
+    if (expr == NULL || var_table == NULL || sweep_variable == NULL || sweep == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (expr -> result == NO_OPERAND)
+        return TREE_ERROR_NULL_PTR;
+
+    int variable = find_variable_by_name(var_table, sweep_variable);
+    if (variable == OPERATION_FAILED || variable >= expr -> number_of_variables)
+        return TREE_ERROR_VARIABLE_NOT_FOUND;
+
+    double*        values       = (double*)       calloc((size_t)expr -> number_of_variables + 1, sizeof(double));
+    double*        slots        = (double*)       calloc(expr -> size + 1, sizeof(double));
+    variable_mask* dependencies = (variable_mask*)calloc(expr -> size + 1, sizeof(variable_mask));
+
+    tree_error_type error = TREE_ERROR_NO;
+
+    if (values == NULL || slots == NULL || dependencies == NULL)
+        error = TREE_ERROR_ALLOCATION;
+
+    if (error == TREE_ERROR_NO)
+        error = load_invariant_values(expr, var_table, variable, values);
+
+    if (error == TREE_ERROR_NO)
+        error = compute_variable_dependencies(expr, dependencies);
+
+    variable_mask sweep_mask = (variable_mask)1 << variable;
+
+    // инварианты считаются один раз; зависящие от развёртки инструкции здесь пропускаются,
+    // чтобы их ошибки области определения не мешали подготовке
+    for (size_t i = 0; error == TREE_ERROR_NO && i < expr -> size; i++)
+        if ((dependencies[i] & sweep_mask) == 0)
+            error = execute_instruction(expr, i, values, slots);
+
+    if (error == TREE_ERROR_NO)
+    {
+        sweep_expression_destructor(sweep);
+        sweep -> sweep_variable = variable;
+        error = build_residual(expr, dependencies, sweep_mask, slots, sweep);
+    }
+
+    free(values);
+    free(slots);
+    free(dependencies);
+
+    return error;
+}
+
+
+tree_error_type evaluate_sweep(const sweep_expression* sweep, const double* sweep_values,
+                               size_t count, double* results)
+{
+    if (sweep == NULL || sweep_values == NULL || results == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    return evaluate_batch(&sweep -> residual, &sweep_values, count, results);
+}
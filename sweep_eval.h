@@ -0,0 +1,26 @@
+#ifndef SWEEP_EVAL_H_
+#define SWEEP_EVAL_H_
+
+#include <stddef.h>
+
+#include "variable_parse.h"
+#include "tree_error_types.h"
+#include "compiled_expression.h"
+
+// Остаточное выражение: все поддеревья, не зависящие от переменной развёртки,
+// вычислены один раз и заменены константами; единственная переменная имеет индекс 0
+struct sweep_expression
+{
+    compiled_expression residual;
+    int                 sweep_variable;
+    size_t              hoisted_instructions;
+};
+
+tree_error_type sweep_expression_constructor(sweep_expression* sweep);
+tree_error_type sweep_expression_destructor (sweep_expression* sweep);
+tree_error_type prepare_sweep (const compiled_expression* expr, variable_table* var_table,
+                               const char* sweep_variable, sweep_expression* sweep);
+tree_error_type evaluate_sweep(const sweep_expression* sweep, const double* sweep_values,
+                               size_t count, double* results);
+
+#endif // SWEEP_EVAL_H_
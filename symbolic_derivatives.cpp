@@ -0,0 +1,617 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "operations.h"
+#include "tree_base.h"
+#include "logic_functions.h"
+#include "symbolic_derivatives.h"
+
+const size_t INITIAL_DAG_CAPACITY = 64;
+const size_t NO_NODE              = SIZE_MAX;
+
+// Состояние одного построения: таблица хэш-консинга (номер узла в nodes по его
+// структуре) и строки производных rows[номер * n + k] = d(узел)/d(переменная k)
+struct derivative_context
+{
+    symbolic_derivatives* result;
+
+    size_t*  table;
+    size_t   table_capacity;
+
+    node_t** rows;
+
+    node_t*  zero;
+    node_t*  one;
+    node_t*  minus_one;
+};
+
+// ==================== ХЭШ-КОНСИНГ ====================
+
+// -0.0 + 0.0 == +0.0, поэтому оба нуля дают один узел
+static uint64_t number_bits(double number)
+{
+    number += 0.0;
+
+    uint64_t bits = 0;
+    memcpy(&bits, &number, sizeof(bits));
+
+    return bits;
+}
+
+
+static size_t hash_node_fields(node_type type, value_of_tree_element data, const node_t* left, const node_t* right)
+{
+    size_t hash = (size_t)type * 0x9E3779B97F4A7C15ull;
+
+    switch (type)
+    {
+        case NODE_NUM:
+            hash ^= number_bits(data.num_value);
+            break;
+        case NODE_VAR:
+            hash ^= compute_hash(data.var_definition.name);
+            break;
+        case NODE_OP:
+            hash ^= (size_t)data.op_value;
+            break;
+        default:
+            break;
+    }
+
+    hash = (hash ^ (uintptr_t)left)  * 0xFF51AFD7ED558CCDull;
+    hash = (hash ^ (uintptr_t)right) * 0xC4CEB9FE1A85EC53ull;
+
+    return hash ^ (hash >> 29);
+}
+
+
+static bool node_has_fields(const node_t* node, node_type type, value_of_tree_element data,
+                            const node_t* left, const node_t* right)
+{
+    if (node -> type != type || node -> left != left || node -> right != right)
+        return false;
+
+    switch (type)
+    {
+        case NODE_NUM: return number_bits(node -> data.num_value) == number_bits(data.num_value);
+        case NODE_VAR: return strcmp(node -> data.var_definition.name, data.var_definition.name) == 0;
+        case NODE_OP:  return node -> data.op_value == data.op_value;
+        default:       return false;
+    }
+}
+
+
+static size_t find_slot(const derivative_context* context, node_type type, value_of_tree_element data,
+                        const node_t* left, const node_t* right)
+{
+    size_t mask = context -> table_capacity - 1;
+    size_t slot = hash_node_fields(type, data, left, right) & mask;
+
+    while (context -> table[slot] != NO_NODE &&
+           !node_has_fields(context -> result -> nodes[context -> table[slot]], type, data, left, right))
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+
+static size_t find_node_index(const derivative_context* context, const node_t* node)
+{
+    return context -> table[find_slot(context, node -> type, node -> data, node -> left, node -> right)];
+}
+
+
+static tree_error_type grow_context(derivative_context* context)
+{
+    symbolic_derivatives* result = context -> result;
+    size_t n = (size_t)result -> number_of_variables;
+    size_t capacity = (result -> capacity == 0) ? INITIAL_DAG_CAPACITY : result -> capacity * 2;
+
+    node_t** nodes = (node_t**)realloc(result -> nodes, capacity * sizeof(node_t*));
+    if (nodes == NULL)
+        return TREE_ERROR_ALLOCATION;
+    result -> nodes = nodes;
+
+    node_t** rows = (node_t**)realloc(context -> rows, capacity * n * sizeof(node_t*));
+    if (rows == NULL)
+        return TREE_ERROR_ALLOCATION;
+    memset(rows + result -> capacity * n, 0, (capacity - result -> capacity) * n * sizeof(node_t*));
+    context -> rows = rows;
+
+    result -> capacity = capacity;
+
+    // таблица заполнена не больше чем наполовину
+    size_t* table = (size_t*)malloc(2 * capacity * sizeof(size_t));
+    if (table == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    free(context -> table);
+    context -> table          = table;
+    context -> table_capacity = 2 * capacity;
+
+    for (size_t i = 0; i < context -> table_capacity; i++)
+        table[i] = NO_NODE;
+
+    for (size_t i = 0; i < result -> size; i++)
+    {
+        node_t* node = result -> nodes[i];
+        table[find_slot(context, node -> type, node -> data, node -> left, node -> right)] = i;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+// Единственный способ создать узел DAG: структурно равный узел возвращается повторно
+static node_t* intern_node(derivative_context* context, node_type type, value_of_tree_element data,
+                           node_t* left, node_t* right)
+{
+    if ((type == NODE_OP && right == NULL) || (type == NODE_VAR && data.var_definition.name == NULL))
+        return NULL;
+
+    symbolic_derivatives* result = context -> result;
+
+    size_t slot = find_slot(context, type, data, left, right);
+    if (context -> table[slot] != NO_NODE)
+        return result -> nodes[context -> table[slot]];
+
+    if (result -> size == result -> capacity)
+    {
+        if (grow_context(context) != TREE_ERROR_NO)
+            return NULL;
+
+        slot = find_slot(context, type, data, left, right);
+    }
+
+    if (type == NODE_VAR)
+    {
+        data.var_definition.name = strdup(data.var_definition.name);
+        if (data.var_definition.name == NULL)
+            return NULL;
+    }
+
+    node_t* node = create_node(type, data, left, right);
+    if (node == NULL)
+    {
+        if (type == NODE_VAR)
+            free(data.var_definition.name);
+        return NULL;
+    }
+
+    context -> table[slot] = result -> size;
+    result -> nodes[result -> size++] = node;
+
+    return node;
+}
+
+// ==================== ПРОСТЕЙШИЕ УПРОЩЕНИЯ ====================
+
+static bool is_zero_node(const node_t* node)
+{
+    return node -> type == NODE_NUM && is_zero(node -> data.num_value);
+}
+
+
+static bool is_one_node(const node_t* node)
+{
+    return node -> type == NODE_NUM && is_one(node -> data.num_value);
+}
+
+
+static node_t* make_num(derivative_context* context, double value)
+{
+    return intern_node(context, NODE_NUM, (value_of_tree_element){.num_value = value}, NULL, NULL);
+}
+
+
+static node_t* make_op(derivative_context* context, operation_type op, node_t* left, node_t* right)
+{
+    if (right == NULL || (is_binary(op) && left == NULL))
+        return NULL;
+
+    return intern_node(context, NODE_OP, (value_of_tree_element){.op_value = op}, left, right);
+}
+
+
+static node_t* make_add(derivative_context* context, node_t* left, node_t* right)
+{
+    if (left == NULL || right == NULL) return NULL;
+    if (is_zero_node(left))            return right;
+    if (is_zero_node(right))           return left;
+
+    if (left -> type == NODE_NUM && right -> type == NODE_NUM)
+        return make_num(context, left -> data.num_value + right -> data.num_value);
+
+    return make_op(context, OP_ADD, left, right);
+}
+
+
+static node_t* make_mul(derivative_context* context, node_t* left, node_t* right)
+{
+    if (left == NULL || right == NULL)              return NULL;
+    if (is_zero_node(left) || is_zero_node(right))  return context -> zero;
+    if (is_one_node(left))                          return right;
+    if (is_one_node(right))                         return left;
+
+    if (left -> type == NODE_NUM && right -> type == NODE_NUM)
+        return make_num(context, left -> data.num_value * right -> data.num_value);
+
+    return make_op(context, OP_MUL, left, right);
+}
+
+
+static node_t* make_sub(derivative_context* context, node_t* left, node_t* right)
+{
+    if (left == NULL || right == NULL) return NULL;
+    if (is_zero_node(right))           return left;
+    if (is_zero_node(left))            return make_mul(context, context -> minus_one, right);
+
+    if (left -> type == NODE_NUM && right -> type == NODE_NUM)
+        return make_num(context, left -> data.num_value - right -> data.num_value);
+
+    return make_op(context, OP_SUB, left, right);
+}
+
+
+static node_t* make_div(derivative_context* context, node_t* left, node_t* right)
+{
+    if (left == NULL || right == NULL) return NULL;
+    if (is_zero_node(left))            return context -> zero;
+    if (is_one_node(right))            return left;
+
+    return make_op(context, OP_DIV, left, right);
+}
+
+// ==================== ДИФФЕРЕНЦИРОВАНИЕ DAG ====================
+
+static node_t* derivative_of(const derivative_context* context, size_t index, int variable)
+{
+    return context -> rows[index * (size_t)context -> result -> number_of_variables + (size_t)variable];
+}
+
+
+static node_t* differentiate_operation(derivative_context* context, node_t* node, node_t* left, node_t* right,
+                                       node_t* du, node_t* dv)
+{
+    switch (node -> data.op_value)
+    {
+        case OP_ADD:
+            return make_add(context, du, dv);
+
+        case OP_SUB:
+            return make_sub(context, du, dv);
+
+        case OP_MUL:
+            return make_add(context, make_mul(context, du, right), make_mul(context, left, dv));
+
+        case OP_DIV:
+            if (is_zero_node(dv))
+                return make_div(context, du, right);
+
+            return make_div(context,
+                            make_sub(context, make_mul(context, du, right), make_mul(context, left, dv)),
+                            make_mul(context, right, right));
+
+        case OP_SIN:
+            return make_mul(context, make_op(context, OP_COS, NULL, right), dv);
+
+        case OP_COS:
+            return make_mul(context,
+                            make_mul(context, context -> minus_one, make_op(context, OP_SIN, NULL, right)), dv);
+
+        case OP_LN:
+            return make_div(context, dv, right);
+
+        case OP_EXP:
+            return make_mul(context, node, dv);
+
+        case OP_POW:
+            // (u^c)' = c * u^(c-1) * u',  (a^v)' = a^v * ln a * v'
+            if (is_zero_node(dv))
+                return make_mul(context,
+                                make_mul(context, right,
+                                         make_op(context, OP_POW, left, make_sub(context, right, context -> one))),
+                                du);
+
+            if (is_zero_node(du))
+                return make_mul(context, make_mul(context, node, make_op(context, OP_LN, NULL, left)), dv);
+
+            return make_mul(context, node,
+                            make_add(context,
+                                     make_mul(context, dv, make_op(context, OP_LN, NULL, left)),
+                                     make_mul(context, make_div(context, right, left), du)));
+
+        default:
+            return NULL;
+    }
+}
+
+
+static tree_error_type differentiate_dag_node(derivative_context* context, node_t* node, size_t* index)
+{
+    size_t node_index = find_node_index(context, node);
+    if (node_index == NO_NODE)
+        return TREE_ERROR_INVALID_NODE;
+
+    int n = context -> result -> number_of_variables;
+    *index = node_index;
+
+    if (derivative_of(context, node_index, 0) != NULL)
+        return TREE_ERROR_NO;
+
+    size_t left_index  = NO_NODE;
+    size_t right_index = NO_NODE;
+    tree_error_type error = TREE_ERROR_NO;
+
+    if (node -> type == NODE_OP)
+    {
+        if (node -> left != NULL)
+            error = differentiate_dag_node(context, node -> left, &left_index);
+
+        if (error == TREE_ERROR_NO)
+            error = differentiate_dag_node(context, node -> right, &right_index);
+
+        if (error != TREE_ERROR_NO)
+            return error;
+    }
+
+    // строка rows может переехать при росте, поэтому индексация заново после каждого узла
+    for (int k = 0; k < n; k++)
+    {
+        node_t* derivative = context -> zero;
+
+        if (node -> type == NODE_VAR)
+        {
+            if (strcmp(node -> data.var_definition.name, context -> result -> variable_names[k]) == 0)
+                derivative = context -> one;
+        }
+        else if (node -> type == NODE_OP)
+        {
+            node_t* du = (left_index != NO_NODE) ? derivative_of(context, left_index, k) : context -> zero;
+            node_t* dv = derivative_of(context, right_index, k);
+
+            derivative = differentiate_operation(context, node, node -> left, node -> right, du, dv);
+        }
+
+        if (derivative == NULL)
+            return TREE_ERROR_ALLOCATION;
+
+        context -> rows[node_index * (size_t)n + (size_t)k] = derivative;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+static node_t* import_subtree(derivative_context* context, node_t* node)
+{
+    if (node == NULL)
+        return NULL;
+
+    node_t* left  = import_subtree(context, node -> left);
+    node_t* right = import_subtree(context, node -> right);
+
+    if ((node -> left != NULL && left == NULL) || (node -> right != NULL && right == NULL))
+        return NULL;
+
+    return intern_node(context, node -> type, node -> data, left, right);
+}
+
+// ==================== ПОСТРОЕНИЕ ====================
+
+static tree_error_type prepare_context(derivative_context* context, variable_table* var_table,
+                                       size_t number_of_trees, bool with_hessian)
+{
+    symbolic_derivatives* result = context -> result;
+    size_t n = (size_t)var_table -> number_of_variables;
+
+    result -> number_of_functions = number_of_trees;
+    result -> number_of_variables = var_table -> number_of_variables;
+
+    result -> variable_names = (char(*)[MAX_VARIABLE_LENGTH])calloc(n, MAX_VARIABLE_LENGTH);
+    result -> functions      = (node_t**)calloc(number_of_trees,     sizeof(node_t*));
+    result -> jacobian       = (node_t**)calloc(number_of_trees * n, sizeof(node_t*));
+
+    if (with_hessian)
+        result -> hessians = (node_t**)calloc(number_of_trees * n * n, sizeof(node_t*));
+
+    if (result -> variable_names == NULL || result -> functions == NULL || result -> jacobian == NULL ||
+        (with_hessian && result -> hessians == NULL))
+        return TREE_ERROR_ALLOCATION;
+
+    for (size_t i = 0; i < n; i++)
+        memcpy(result -> variable_names[i], var_table -> variables[i].name, MAX_VARIABLE_LENGTH);
+
+    tree_error_type error = grow_context(context);
+    if (error != TREE_ERROR_NO)
+        return error;
+
+    context -> zero      = make_num(context,  0.0);
+    context -> one       = make_num(context,  1.0);
+    context -> minus_one = make_num(context, -1.0);
+
+    if (context -> zero == NULL || context -> one == NULL || context -> minus_one == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    return TREE_ERROR_NO;
+}
+
+
+static tree_error_type differentiate_function(derivative_context* context, size_t function, node_t* root)
+{
+    symbolic_derivatives* result = context -> result;
+    size_t n = (size_t)result -> number_of_variables;
+
+    result -> functions[function] = import_subtree(context, root);
+    if (result -> functions[function] == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    size_t index = NO_NODE;
+    tree_error_type error = differentiate_dag_node(context, result -> functions[function], &index);
+    if (error != TREE_ERROR_NO)
+        return error;
+
+    for (size_t k = 0; k < n; k++)
+        result -> jacobian[function * n + k] = derivative_of(context, index, (int)k);
+
+    if (result -> hessians == NULL)
+        return TREE_ERROR_NO;
+
+    node_t** hessian = result -> hessians + function * n * n;
+
+    // вторые производные по уже построенным первым: общие подвыражения
+    // градиента и самой функции дифференцируются один раз
+    for (size_t i = 0; i < n; i++)
+    {
+        error = differentiate_dag_node(context, result -> jacobian[function * n + i], &index);
+        if (error != TREE_ERROR_NO)
+            return error;
+
+        for (size_t j = i; j < n; j++)
+        {
+            hessian[i * n + j] = derivative_of(context, index, (int)j);
+            hessian[j * n + i] = hessian[i * n + j];
+        }
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+static node_t* copy_dag_node(node_t* node)
+{
+    if (node == NULL)
+        return NULL;
+
+    node_t* left  = copy_dag_node(node -> left);
+    node_t* right = copy_dag_node(node -> right);
+
+    if ((node -> left != NULL && left == NULL) || (node -> right != NULL && right == NULL))
+    {
+        free_subtree(left);
+        free_subtree(right);
+        return NULL;
+    }
+
+    value_of_tree_element data = node -> data;
+    if (node -> type == NODE_VAR)
+    {
+        data.var_definition.name = strdup(node -> data.var_definition.name);
+        if (data.var_definition.name == NULL)
+            return NULL;
+    }
+
+    node_t* copy = create_node(node -> type, data, left, right);
+    if (copy == NULL)
+    {
+        if (node -> type == NODE_VAR)
+            free(data.var_definition.name);
+        free_subtree(left);
+        free_subtree(right);
+    }
+
+    return copy;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type symbolic_derivatives_constructor(symbolic_derivatives* derivatives)
+{
+    if (derivatives == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    derivatives -> nodes               = NULL;
+    derivatives -> size                = 0;
+    derivatives -> capacity            = 0;
+    derivatives -> number_of_functions = 0;
+    derivatives -> number_of_variables = 0;
+    derivatives -> variable_names      = NULL;
+    derivatives -> functions           = NULL;
+    derivatives -> jacobian            = NULL;
+    derivatives -> hessians            = NULL;
+
+    return TREE_ERROR_NO;
+}
+
+
+tree_error_type symbolic_derivatives_destructor(symbolic_derivatives* derivatives)
+{
+    if (derivatives == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    for (size_t i = 0; i < derivatives -> size; i++)
+    {
+        node_t* node = derivatives -> nodes[i];
+        if (node -> type == NODE_VAR)
+            free(node -> data.var_definition.name);
+        free(node);
+    }
+
+    free(derivatives -> nodes);
+    free(derivatives -> variable_names);
+    free(derivatives -> functions);
+    free(derivatives -> jacobian);
+    free(derivatives -> hessians);
+
+    return symbolic_derivatives_constructor(derivatives);
+}
+
+
+tree_error_type differentiate_trees_all(tree_t* trees, size_t number_of_trees, variable_table* var_table,
+                                        bool with_hessian, symbolic_derivatives* derivatives)
+{
+    if (trees == NULL || var_table == NULL || derivatives == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    for (size_t i = 0; i < number_of_trees; i++)
+        if (trees[i].root == NULL)
+            return TREE_ERROR_NULL_PTR;
+
+    if (var_table -> number_of_variables <= 0)
+        return TREE_ERROR_NO_VARIABLES;
+
+    symbolic_derivatives_destructor(derivatives);
+
+    derivative_context context = {};
+    context.result = derivatives;
+
+    tree_error_type error = prepare_context(&context, var_table, number_of_trees, with_hessian);
+
+    for (size_t i = 0; error == TREE_ERROR_NO && i < number_of_trees; i++)
+        error = differentiate_function(&context, i, trees[i].root);
+
+    free(context.table);
+    free(context.rows);
+
+    if (error != TREE_ERROR_NO)
+        symbolic_derivatives_destructor(derivatives);
+
+    return error;
+}
+
+
+tree_error_type differentiate_tree_all(tree_t* tree, variable_table* var_table,
+                                       bool with_hessian, symbolic_derivatives* derivatives)
+{
+    return differentiate_trees_all(tree, 1, var_table, with_hessian, derivatives);
+}
+
+
+tree_error_type extract_derivative_tree(node_t* node, tree_t* result_tree)
+{
+    if (node == NULL || result_tree == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    node_t* root = copy_dag_node(node);
+    if (root == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    result_tree -> root = root;
+    result_tree -> size = count_tree_nodes(root);
+
+    return TREE_ERROR_NO;
+}
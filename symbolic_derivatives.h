@@ -0,0 +1,39 @@
+#ifndef SYMBOLIC_DERIVATIVES_H_
+#define SYMBOLIC_DERIVATIVES_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "tree_common.h"
+#include "variable_parse.h"
+#include "tree_error_types.h"
+
+// Все частные производные набора функций по переменным variable_table за один проход.
+// Узлы хранятся как DAG без повторов: одинаковые подвыражения (копии исходных
+// функций, cos u, v*v, u^v, ...) - один узел, общий для всех элементов якобиана и гессиана.
+// Владелец узлов - массив nodes, поэтому free_subtree и оптимизация к ним неприменимы;
+// самостоятельное дерево возвращает extract_derivative_tree
+struct symbolic_derivatives
+{
+    node_t** nodes;
+    size_t   size;
+    size_t   capacity;
+
+    size_t   number_of_functions;
+    int      number_of_variables;
+    char   (*variable_names)[MAX_VARIABLE_LENGTH];
+
+    node_t** functions;  // [number_of_functions]
+    node_t** jacobian;   // [number_of_functions * number_of_variables], строка функции - её градиент
+    node_t** hessians;   // [number_of_functions * number_of_variables^2] или NULL, H[i][j] и H[j][i] - один узел
+};
+
+tree_error_type symbolic_derivatives_constructor(symbolic_derivatives* derivatives);
+tree_error_type symbolic_derivatives_destructor (symbolic_derivatives* derivatives);
+tree_error_type differentiate_trees_all         (tree_t* trees, size_t number_of_trees, variable_table* var_table,
+                                                 bool with_hessian, symbolic_derivatives* derivatives);
+tree_error_type differentiate_tree_all          (tree_t* tree, variable_table* var_table,
+                                                 bool with_hessian, symbolic_derivatives* derivatives);
+tree_error_type extract_derivative_tree         (node_t* node, tree_t* result_tree);
+
+#endif // SYMBOLIC_DERIVATIVES_H_
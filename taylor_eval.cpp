@@ -0,0 +1,315 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "taylor_eval.h"
+#include "logic_functions.h"
+
+// ==================== РЕКУРРЕНТНЫЕ ФОРМУЛЫ ====================
+
+// Все ряды имеют длину length = order + 1; out не совпадает с входами
+
+static void series_multiply(const double* left, const double* right, double* out, size_t length)
+{
+    for (size_t k = 0; k < length; k++)
+    {
+        double sum = 0.0;
+        for (size_t j = 0; j <= k; j++)
+            sum += left[j] * right[k - j];
+        out[k] = sum;
+    }
+}
+
+
+static tree_error_type series_divide(const double* left, const double* right, double* out, size_t length)
+{
+    if (is_zero(right[0]))
+        return TREE_ERROR_DIVISION_BY_ZERO;
+
+    for (size_t k = 0; k < length; k++)
+    {
+        double sum = left[k];
+        for (size_t j = 1; j <= k; j++)
+            sum -= right[j] * out[k - j];
+        out[k] = sum / right[0];
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+static void series_exp(const double* argument, double* out, size_t length)
+{
+    out[0] = exp(argument[0]);
+
+    for (size_t k = 1; k < length; k++)
+    {
+        double sum = 0.0;
+        for (size_t j = 1; j <= k; j++)
+            sum += (double)j * argument[j] * out[k - j];
+        out[k] = sum / (double)k;
+    }
+}
+
+
+static tree_error_type series_ln(const double* argument, double* out, size_t length)
+{
+    if (argument[0] <= 0)
+        return TREE_ERROR_YCHI_MATAN;
+
+    out[0] = log(argument[0]);
+
+    for (size_t k = 1; k < length; k++)
+    {
+        double sum = 0.0;
+        for (size_t j = 1; j < k; j++)
+            sum += (double)j * out[j] * argument[k - j];
+        out[k] = (argument[k] - sum / (double)k) / argument[0];
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+// sin и cos считаются парой: рекуррентность каждого использует другой
+static void series_sin_cos(const double* argument, double* sine, double* cosine, size_t length)
+{
+    sine[0]   = sin(argument[0]);
+    cosine[0] = cos(argument[0]);
+
+    for (size_t k = 1; k < length; k++)
+    {
+        double sine_sum = 0.0, cosine_sum = 0.0;
+        for (size_t j = 1; j <= k; j++)
+        {
+            sine_sum   += (double)j * argument[j] * cosine[k - j];
+            cosine_sum += (double)j * argument[j] * sine[k - j];
+        }
+        sine[k]   =  sine_sum   / (double)k;
+        cosine[k] = -cosine_sum / (double)k;
+    }
+}
+
+
+// u^a с постоянным a: k * u_0 * w_k = sum_{j=1..k} (a * j - (k - j)) * u_j * w_{k-j}
+static tree_error_type series_constant_power(const double* base, double exponent, double* out, size_t length)
+{
+    out[0] = pow(base[0], exponent);
+
+    if (is_zero(base[0]))
+    {
+        // при нулевом основании формула делит на ноль; целая неотрицательная степень
+        // считается повторным умножением рядов
+        if (exponent < 0 || !is_zero(exponent - floor(exponent)))
+            return TREE_ERROR_DIVISION_BY_ZERO;
+
+        double* product = (double*)calloc(length, sizeof(double));
+        if (product == NULL)
+            return TREE_ERROR_ALLOCATION;
+
+        memset(out, 0, length * sizeof(double));
+        out[0] = 1.0;
+
+        for (long i = 0; i < (long)exponent; i++)
+        {
+            series_multiply(out, base, product, length);
+            memcpy(out, product, length * sizeof(double));
+        }
+
+        free(product);
+        return TREE_ERROR_NO;
+    }
+
+    for (size_t k = 1; k < length; k++)
+    {
+        double sum = 0.0;
+        for (size_t j = 1; j <= k; j++)
+            sum += (exponent * (double)j - (double)(k - j)) * base[j] * out[k - j];
+        out[k] = sum / ((double)k * base[0]);
+    }
+
+    return TREE_ERROR_NO;
+}
+
+
+static bool is_constant_series(const double* series, size_t length)
+{
+    for (size_t k = 1; k < length; k++)
+        if (!is_zero(series[k]))
+            return false;
+
+    return true;
+}
+
+
+// u^v = exp(v * ln u); temporary - буфер на 2 * length
+static tree_error_type series_power(const double* base, const double* exponent, double* out,
+                                    double* temporary, size_t length)
+{
+    if (is_constant_series(exponent, length))
+        return series_constant_power(base, exponent[0], out, length);
+
+    double* logarithm = temporary;
+    double* product   = temporary + length;
+
+    tree_error_type error = series_ln(base, logarithm, length);
+    if (error != TREE_ERROR_NO)
+        return error;
+
+    series_multiply(exponent, logarithm, product, length);
+    series_exp(product, out, length);
+
+    return TREE_ERROR_NO;
+}
+
+// ==================== ВЫЧИСЛЕНИЕ ПРОГРАММЫ ====================
+
+static tree_error_type execute_taylor_instruction(const compiled_expression* expr, size_t index,
+                                                  const double* variables, int variable,
+                                                  double* series, double* temporary, size_t length)
+{
+    const instruction_t* instruction = &expr -> instructions[index];
+
+    double* out = series + index * length;
+    const double* left  = (instruction -> left  != NO_OPERAND) ? series + (size_t)instruction -> left  * length : NULL;
+    const double* right = (instruction -> right != NO_OPERAND) ? series + (size_t)instruction -> right * length : NULL;
+
+    switch (instruction -> code)
+    {
+        case INSTR_NUM:
+            memset(out, 0, length * sizeof(double));
+            out[0] = instruction -> value;
+            return TREE_ERROR_NO;
+
+        case INSTR_VAR:
+            if (variables == NULL)
+                return TREE_ERROR_NULL_PTR;
+            memset(out, 0, length * sizeof(double));
+            out[0] = variables[instruction -> variable];
+            if (instruction -> variable == variable && length > 1)
+                out[1] = 1.0;
+            return TREE_ERROR_NO;
+
+        case INSTR_ADD:
+            for (size_t k = 0; k < length; k++)
+                out[k] = left[k] + right[k];
+            return TREE_ERROR_NO;
+
+        case INSTR_SUB:
+            for (size_t k = 0; k < length; k++)
+                out[k] = left[k] - right[k];
+            return TREE_ERROR_NO;
+
+        case INSTR_MUL:
+            series_multiply(left, right, out, length);
+            return TREE_ERROR_NO;
+
+        case INSTR_DIV:
+            return series_divide(left, right, out, length);
+
+        case INSTR_SIN:
+            series_sin_cos(right, out, temporary, length);
+            return TREE_ERROR_NO;
+
+        case INSTR_COS:
+            series_sin_cos(right, temporary, out, length);
+            return TREE_ERROR_NO;
+
+        case INSTR_POW:
+            return series_power(left, right, out, temporary, length);
+
+        case INSTR_POWI:
+            return series_constant_power(left, instruction -> value, out, length);
+
+        case INSTR_LN:
+            return series_ln(right, out, length);
+
+        case INSTR_EXP:
+            series_exp(right, out, length);
+            return TREE_ERROR_NO;
+
+        default:
+            return TREE_ERROR_UNKNOWN_OPERATION;
+    }
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type evaluate_taylor(const compiled_expression* expr, const double* variables, int variable,
+                                size_t order, double* derivatives)
+{
+    if (expr == NULL || derivatives == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (expr -> result == NO_OPERAND)
+        return TREE_ERROR_NULL_PTR;
+
+    size_t length = order + 1;
+
+    double* series    = (double*)calloc(expr -> size * length + 1, sizeof(double));
+    double* temporary = (double*)calloc(2 * length, sizeof(double));
+
+    tree_error_type error = TREE_ERROR_NO;
+
+    if (series == NULL || temporary == NULL)
+        error = TREE_ERROR_ALLOCATION;
+
+    for (size_t i = 0; error == TREE_ERROR_NO && i < expr -> size; i++)
+        error = execute_taylor_instruction(expr, i, variables, variable, series, temporary, length);
+
+    if (error == TREE_ERROR_NO)
+    {
+        const double* result = series + (size_t)expr -> result * length;
+
+        double factorial = 1.0;
+        for (size_t k = 0; k < length; k++)
+        {
+            if (k > 0)
+                factorial *= (double)k;
+            derivatives[k] = result[k] * factorial;
+        }
+    }
+
+    free(series);
+    free(temporary);
+
+    return error;
+}
+
+
+tree_error_type evaluate_taylor_tree(tree_t* tree, variable_table* var_table, const char* variable_name,
+                                     size_t order, double* derivatives)
+{
+    if (tree == NULL || var_table == NULL || variable_name == NULL || derivatives == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    int variable = find_variable_by_name(var_table, variable_name);
+    if (variable == OPERATION_FAILED)
+        return TREE_ERROR_VARIABLE_NOT_FOUND;
+
+    compiled_expression expr = {};
+    compiled_expression_constructor(&expr);
+
+    double* values = (double*)calloc((size_t)var_table -> number_of_variables + 1, sizeof(double));
+    if (values == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    tree_error_type error = compile_tree(tree, var_table, &expr);
+
+    for (int i = 0; error == TREE_ERROR_NO && i < var_table -> number_of_variables; i++)
+    {
+        if (!var_table -> variables[i].is_defined)
+            error = TREE_ERROR_VARIABLE_UNDEFINED;
+        else
+            values[i] = var_table -> variables[i].value;
+    }
+
+    if (error == TREE_ERROR_NO)
+        error = evaluate_taylor(&expr, values, variable, order, derivatives);
+
+    free(values);
+    compiled_expression_destructor(&expr);
+
+    return error;
+}
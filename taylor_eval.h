@@ -0,0 +1,21 @@
+#ifndef TAYLOR_EVAL_H_
+#define TAYLOR_EVAL_H_
+
+#include <stddef.h>
+
+#include "tree_common.h"
+#include "variable_parse.h"
+#include "tree_error_types.h"
+#include "compiled_expression.h"
+
+// Усечённые ряды Тейлора: каждая инструкция получает коэффициенты
+// c_0..c_order своего значения по одной переменной, производные
+// f^(k) = k! * c_k. Стоимость O(order^2 * размер программы), без символьных деревьев
+tree_error_type evaluate_taylor     (const compiled_expression* expr, const double* variables, int variable,
+                                     size_t order, double* derivatives);
+
+// derivatives - массив на order + 1 элементов, значения переменных берутся из var_table
+tree_error_type evaluate_taylor_tree(tree_t* tree, variable_table* var_table, const char* variable_name,
+                                     size_t order, double* derivatives);
+
+#endif // TAYLOR_EVAL_H_
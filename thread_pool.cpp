@@ -0,0 +1,261 @@
+#include <new>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <assert.h>
+#include <system_error>
+#include <condition_variable>
+
+#include "thread_pool.h"
+
+struct pool_task
+{
+    task_function function;
+    void*         argument;
+    task_group*   group;
+};
+
+struct worker_queue
+{
+    worker_queue() : mutex(), tasks() {}
+
+    std::mutex            mutex;
+    std::deque<pool_task> tasks;
+};
+
+// Очередь с номером number_of_threads общая для внешних потоков,
+// которые отправляют задачи и ждут их в task_group_wait
+struct thread_pool
+{
+    explicit thread_pool(size_t size) :
+        number_of_threads(size), queues(NULL), threads(NULL), sleep_mutex(), wake_up(), queued(0), stopping(false) {}
+    thread_pool(const thread_pool&)            = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    size_t                  number_of_threads;
+    worker_queue*           queues;
+    std::thread*            threads;
+    std::mutex              sleep_mutex;
+    std::condition_variable wake_up;
+    std::atomic<size_t>     queued;
+    std::atomic<bool>       stopping;
+};
+
+static thread_local const thread_pool* current_pool         = NULL;
+static thread_local size_t             current_worker_index = 0;
+
+// ==================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ====================
+
+static bool pop_own_task(worker_queue* queue, pool_task* task)
+{
+    std::lock_guard<std::mutex> lock(queue -> mutex);
+
+    if (queue -> tasks.empty())
+        return false;
+
+    *task = queue -> tasks.back();
+    queue -> tasks.pop_back();
+    return true;
+}
+
+
+static bool steal_task(worker_queue* queue, pool_task* task)
+{
+    std::lock_guard<std::mutex> lock(queue -> mutex);
+
+    if (queue -> tasks.empty())
+        return false;
+
+    *task = queue -> tasks.front();
+    queue -> tasks.pop_front();
+    return true;
+}
+
+
+static bool find_task(thread_pool* pool, size_t index, pool_task* task)
+{
+    if (pool -> queued.load(std::memory_order_acquire) == 0)
+        return false;
+
+    size_t number_of_queues = pool -> number_of_threads + 1;
+
+    bool found = pop_own_task(&pool -> queues[index], task);
+
+    for (size_t offset = 1; !found && offset < number_of_queues; offset++)
+        found = steal_task(&pool -> queues[(index + offset) % number_of_queues], task);
+
+    if (found)
+        pool -> queued.fetch_sub(1, std::memory_order_acq_rel);
+
+    return found;
+}
+
+
+static void run_task(const pool_task* task)
+{
+    task -> function(task -> argument);
+    task -> group -> pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+
+static void worker_loop(thread_pool* pool, size_t index)
+{
+    current_pool         = pool;
+    current_worker_index = index;
+
+    while (true)
+    {
+        pool_task task = {};
+        if (find_task(pool, index, &task))
+        {
+            run_task(&task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(pool -> sleep_mutex);
+        pool -> wake_up.wait(lock, [pool] { return pool -> stopping.load() || pool -> queued.load() > 0; });
+
+        if (pool -> stopping.load() && pool -> queued.load() == 0)
+            return;
+    }
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+tree_error_type thread_pool_create(size_t number_of_threads, thread_pool** created)
+{
+    if (created == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    *created = NULL;
+
+    if (number_of_threads == 0)
+        number_of_threads = std::thread::hardware_concurrency();
+    if (number_of_threads == 0)
+        number_of_threads = 1;
+
+    thread_pool* pool = new (std::nothrow) thread_pool(number_of_threads);
+    if (pool == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    pool -> queues  = new (std::nothrow) worker_queue[number_of_threads + 1];
+    pool -> threads = new (std::nothrow) std::thread [number_of_threads];
+
+    if (pool -> queues == NULL || pool -> threads == NULL)
+    {
+        delete[] pool -> queues;
+        delete[] pool -> threads;
+        delete pool;
+        return TREE_ERROR_ALLOCATION;
+    }
+
+    // уже запущенные потоки останавливает thread_pool_destroy, незапущенные не joinable
+    try
+    {
+        for (size_t i = 0; i < number_of_threads; i++)
+            pool -> threads[i] = std::thread(worker_loop, pool, i);
+    }
+    catch (const std::system_error&)
+    {
+        thread_pool_destroy(pool);
+        return TREE_ERROR_ALLOCATION;
+    }
+
+    *created = pool;
+    return TREE_ERROR_NO;
+}
+
+
+void thread_pool_destroy(thread_pool* pool)
+{
+    if (pool == NULL)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(pool -> sleep_mutex);
+        pool -> stopping.store(true);
+    }
+    pool -> wake_up.notify_all();
+
+    for (size_t i = 0; i < pool -> number_of_threads; i++)
+        if (pool -> threads[i].joinable())
+            pool -> threads[i].join();
+
+    delete[] pool -> threads;
+    delete[] pool -> queues;
+    delete pool;
+}
+
+
+size_t thread_pool_size(const thread_pool* pool)
+{
+    assert(pool != NULL);
+
+    return pool -> number_of_threads;
+}
+
+
+size_t thread_pool_worker_index(const thread_pool* pool)
+{
+    assert(pool != NULL);
+
+    return (current_pool == pool) ? current_worker_index : pool -> number_of_threads;
+}
+
+
+void task_group_init(task_group* group)
+{
+    assert(group != NULL);
+
+    group -> pending.store(0);
+}
+
+
+tree_error_type thread_pool_submit(thread_pool* pool, task_group* group, task_function function, void* argument)
+{
+    if (pool == NULL || group == NULL || function == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    worker_queue* queue = &pool -> queues[thread_pool_worker_index(pool)];
+    group -> pending.fetch_add(1, std::memory_order_acq_rel);
+
+    // счётчик растёт до вставки, чтобы извлечение задачи никогда не уводило его ниже нуля
+    {
+        std::lock_guard<std::mutex> lock(pool -> sleep_mutex);
+        pool -> queued.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    try
+    {
+        std::lock_guard<std::mutex> lock(queue -> mutex);
+        queue -> tasks.push_back({function, argument, group});
+    }
+    catch (const std::bad_alloc&)
+    {
+        pool -> queued.fetch_sub(1, std::memory_order_acq_rel);
+        group -> pending.fetch_sub(1, std::memory_order_acq_rel);
+        return TREE_ERROR_ALLOCATION;
+    }
+
+    pool -> wake_up.notify_one();
+
+    return TREE_ERROR_NO;
+}
+
+
+void task_group_wait(thread_pool* pool, task_group* group)
+{
+    assert(pool  != NULL);
+    assert(group != NULL);
+
+    size_t index = thread_pool_worker_index(pool);
+
+    while (group -> pending.load(std::memory_order_acquire) > 0)
+    {
+        pool_task task = {};
+        if (find_task(pool, index, &task))
+            run_task(&task);
+        else
+            std::this_thread::yield();
+    }
+}
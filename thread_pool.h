@@ -0,0 +1,29 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <stddef.h>
+#include <atomic>
+
+#include "tree_error_types.h"
+
+typedef void (*task_function)(void* argument);
+
+struct thread_pool;
+
+struct task_group
+{
+    std::atomic<size_t> pending;
+};
+
+// Все потоки вне пула получают индекс number_of_threads и делят одну внешнюю очередь,
+// поэтому ожидающий в task_group_wait может выполнить задачу чужой группы:
+// данные, привязанные к индексу потока, должны это учитывать (см. parallel_eval.cpp)
+tree_error_type thread_pool_create      (size_t number_of_threads, thread_pool** created);
+void            thread_pool_destroy     (thread_pool* pool);
+size_t          thread_pool_size        (const thread_pool* pool);
+size_t          thread_pool_worker_index(const thread_pool* pool);
+void            task_group_init         (task_group* group);
+tree_error_type thread_pool_submit      (thread_pool* pool, task_group* group, task_function function, void* argument);
+void            task_group_wait         (thread_pool* pool, task_group* group);
+
+#endif // THREAD_POOL_H_
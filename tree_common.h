@@ -22,7 +22,7 @@ const int MAX_LENGTH_OF_TEX_EXPRESSION       = 8192;
 const int MAX_CUSTOM_NOTATION_LENGTH         = 2048;
 const int MAX_TEX_DESCRIPTION_LENGTH         = 256;
 const int MAX_FUNC_NAME_LENGTH               = 256;
-const int MAX_NUMBER_OF_DERIVATIVE           = 4;
+const int DEFAULT_NUMBER_OF_DERIVATIVES      = 4;
 
 
 enum node_type
@@ -33,6 +33,7 @@ enum tree_error_type
     TREE_ERROR_NO_VARIABLES            = 16,
     TREE_ERROR_YCHI_MATAN              = 17,
     TREE_ERROR_VARIABLE_ALREADY_EXISTS = 18,
+    TREE_ERROR_BUDGET_EXCEEDED         = 19,
 };
 
 #endif // TREE_ERROR_TYPES_H_
@@ -0,0 +1,290 @@
+#ifndef TYPED_EVAL_H_
+#define TYPED_EVAL_H_
+
+#include <math.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#include "batch_eval.h"
+#include "dual_number.h"
+#include "logic_functions.h"
+#include "power_reduction.h"
+#include "tree_error_types.h"
+#include "compiled_expression.h"
+
+// Вычисление скомпилированного выражения в произвольном скалярном типе.
+// Поэлементные операции каждого типа задаются специализацией scalar_ops
+// и подставляются при компиляции; константы программы хранятся в double
+
+template <typename scalar_t> struct scalar_ops;
+
+template <> struct scalar_ops<float>
+{
+    static float from_double(double number)   { return (float)number; }
+    static bool  is_zero    (float number)    { return fabsf(number) < (float)ZERO_EPSILON; }
+    static bool  is_positive(float number)    { return number > 0; }
+    static float sin        (float argument)  { return sinf(argument); }
+    static float cos        (float argument)  { return cosf(argument); }
+    static float exp        (float argument)  { return expf(argument); }
+    static float ln         (float argument)  { return logf(argument); }
+    static float sqrt       (float argument)  { return sqrtf(argument); }
+    static float pow        (float base, float exponent) { return powf(base, exponent); }
+};
+
+template <> struct scalar_ops<double>
+{
+    static double from_double(double number)   { return number; }
+    static bool   is_zero    (double number)   { return fabs(number) < ZERO_EPSILON; }
+    static bool   is_positive(double number)   { return number > 0; }
+    static double sin        (double argument) { return ::sin(argument); }
+    static double cos        (double argument) { return ::cos(argument); }
+    static double exp        (double argument) { return ::exp(argument); }
+    static double ln         (double argument) { return log(argument); }
+    static double sqrt       (double argument) { return ::sqrt(argument); }
+    static double pow        (double base, double exponent) { return ::pow(base, exponent); }
+};
+
+template <> struct scalar_ops<long double>
+{
+    static long double from_double(double number)        { return number; }
+    static bool        is_zero    (long double number)   { return fabsl(number) < ZERO_EPSILON; }
+    static bool        is_positive(long double number)   { return number > 0; }
+    static long double sin        (long double argument) { return sinl(argument); }
+    static long double cos        (long double argument) { return cosl(argument); }
+    static long double exp        (long double argument) { return expl(argument); }
+    static long double ln         (long double argument) { return logl(argument); }
+    static long double sqrt       (long double argument) { return sqrtl(argument); }
+    static long double pow        (long double base, long double exponent) { return powl(base, exponent); }
+};
+
+template <> struct scalar_ops<dual_number>
+{
+    static dual_number from_double(double number)        { return make_dual(number, 0.0); }
+    static bool        is_zero    (dual_number number)   { return fabs(number.value) < ZERO_EPSILON; }
+    static bool        is_positive(dual_number number)   { return number.value > 0; }
+    static dual_number sin        (dual_number argument) { return dual_sin(argument); }
+    static dual_number cos        (dual_number argument) { return dual_cos(argument); }
+    static dual_number exp        (dual_number argument) { return dual_exp(argument); }
+    static dual_number ln         (dual_number argument) { return dual_ln(argument); }
+    static dual_number sqrt       (dual_number argument) { return dual_sqrt(argument); }
+    static dual_number pow        (dual_number base, dual_number exponent) { return dual_pow(base, exponent); }
+};
+
+// ==================== ПОЭЛЕМЕНТНЫЕ ОПЕРАЦИИ ====================
+
+// порядок операций как в reduced_pow (power_reduction.h); exponent проверен is_reducible_exponent
+template <typename scalar_t>
+scalar_t reduced_pow_as(scalar_t base, double exponent)
+{
+    typedef scalar_ops<scalar_t> ops;
+
+    double magnitude = fabs(exponent);
+    double whole     = floor(magnitude);
+
+    scalar_t result = ops::from_double(1.0);
+    scalar_t square = base;
+
+    for (unsigned power = (unsigned)whole; power != 0; )
+    {
+        if (power & 1u)
+            result = result * square;
+
+        power >>= 1;
+        if (power != 0)
+            square = square * square;
+    }
+
+    if (magnitude > whole)
+        result = result * ops::sqrt(base);
+
+    if (exponent < 0)
+        result = ops::from_double(1.0) / result;
+
+    return result;
+}
+
+
+template <typename scalar_t>
+tree_error_type execute_instruction_as(const compiled_expression* expr, size_t index,
+                                       const scalar_t* variables, scalar_t* slots)
+{
+    typedef scalar_ops<scalar_t> ops;
+
+    const instruction_t* instruction = &expr -> instructions[index];
+
+    scalar_t left  = (instruction -> left  != NO_OPERAND) ? slots[instruction -> left]  : ops::from_double(0.0);
+    scalar_t right = (instruction -> right != NO_OPERAND) ? slots[instruction -> right] : ops::from_double(0.0);
+
+    switch (instruction -> code)
+    {
+        case INSTR_NUM:
+            slots[index] = ops::from_double(instruction -> value);
+            break;
+        case INSTR_VAR:
+            if (variables == NULL)
+                return TREE_ERROR_NULL_PTR;
+            slots[index] = variables[instruction -> variable];
+            break;
+        case INSTR_ADD:
+            slots[index] = left + right;
+            break;
+        case INSTR_SUB:
+            slots[index] = left - right;
+            break;
+        case INSTR_MUL:
+            slots[index] = left * right;
+            break;
+        case INSTR_DIV:
+            if (ops::is_zero(right))
+                return TREE_ERROR_DIVISION_BY_ZERO;
+            slots[index] = left / right;
+            break;
+        case INSTR_SIN:
+            slots[index] = ops::sin(right);
+            break;
+        case INSTR_COS:
+            slots[index] = ops::cos(right);
+            break;
+        case INSTR_POW:
+            slots[index] = ops::pow(left, right);
+            break;
+        case INSTR_POWI:
+            slots[index] = reduced_pow_as(left, instruction -> value);
+            break;
+        case INSTR_LN:
+            if (!ops::is_positive(right))
+                return TREE_ERROR_YCHI_MATAN;
+            slots[index] = ops::ln(right);
+            break;
+        case INSTR_EXP:
+            slots[index] = ops::exp(right);
+            break;
+        default:
+            return TREE_ERROR_UNKNOWN_OPERATION;
+    }
+
+    return TREE_ERROR_NO;
+}
+
+// ==================== ОСНОВНЫЕ ФУНКЦИИ ====================
+
+// slots - буфер на expr -> size элементов
+template <typename scalar_t>
+tree_error_type evaluate_compiled_as(const compiled_expression* expr, const scalar_t* variables,
+                                     scalar_t* slots, scalar_t* result)
+{
+    if (expr == NULL || slots == NULL || result == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (expr -> result == NO_OPERAND)
+        return TREE_ERROR_NULL_PTR;
+
+    for (size_t i = 0; i < expr -> size; i++)
+    {
+        tree_error_type error = execute_instruction_as(expr, i, variables, slots);
+        if (error != TREE_ERROR_NO)
+            return error;
+    }
+
+    *result = slots[expr -> result];
+    return TREE_ERROR_NO;
+}
+
+
+// Блочный вариант: у каждой инструкции свой цикл по блоку, чтобы
+// для float компилятор мог векторизовать его с вдвое большей шириной
+template <typename scalar_t>
+tree_error_type evaluate_batch_as(const compiled_expression* expr, const scalar_t* const* variables,
+                                  size_t count, scalar_t* results)
+{
+    typedef scalar_ops<scalar_t> ops;
+
+    if (expr == NULL || results == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    if (expr -> result == NO_OPERAND)
+        return TREE_ERROR_NULL_PTR;
+
+    if (expr -> number_of_variables > 0 && variables == NULL)
+        return TREE_ERROR_NULL_PTR;
+
+    scalar_t* scratch = (scalar_t*)calloc(expr -> size * BATCH_BLOCK_SIZE + 1, sizeof(scalar_t));
+    if (scratch == NULL)
+        return TREE_ERROR_ALLOCATION;
+
+    tree_error_type error = TREE_ERROR_NO;
+
+    for (size_t start = 0; error == TREE_ERROR_NO && start < count; start += BATCH_BLOCK_SIZE)
+    {
+        size_t block = (count - start < BATCH_BLOCK_SIZE) ? count - start : BATCH_BLOCK_SIZE;
+
+        for (size_t i = 0; error == TREE_ERROR_NO && i < expr -> size; i++)
+        {
+            const instruction_t* instruction = &expr -> instructions[i];
+
+            scalar_t* out = scratch + i * BATCH_BLOCK_SIZE;
+            const scalar_t* left  = (instruction -> left  != NO_OPERAND) ?
+                                    scratch + (size_t)instruction -> left  * BATCH_BLOCK_SIZE : NULL;
+            const scalar_t* right = (instruction -> right != NO_OPERAND) ?
+                                    scratch + (size_t)instruction -> right * BATCH_BLOCK_SIZE : NULL;
+
+            switch (instruction -> code)
+            {
+                case INSTR_NUM:
+                    for (size_t j = 0; j < block; j++) out[j] = ops::from_double(instruction -> value);
+                    break;
+                case INSTR_VAR:
+                    for (size_t j = 0; j < block; j++) out[j] = variables[instruction -> variable][start + j];
+                    break;
+                case INSTR_ADD:
+                    for (size_t j = 0; j < block; j++) out[j] = left[j] + right[j];
+                    break;
+                case INSTR_SUB:
+                    for (size_t j = 0; j < block; j++) out[j] = left[j] - right[j];
+                    break;
+                case INSTR_MUL:
+                    for (size_t j = 0; j < block; j++) out[j] = left[j] * right[j];
+                    break;
+                case INSTR_DIV:
+                    for (size_t j = 0; j < block; j++)
+                        if (ops::is_zero(right[j]))
+                            error = TREE_ERROR_DIVISION_BY_ZERO;
+                    for (size_t j = 0; j < block; j++) out[j] = left[j] / right[j];
+                    break;
+                case INSTR_SIN:
+                    for (size_t j = 0; j < block; j++) out[j] = ops::sin(right[j]);
+                    break;
+                case INSTR_COS:
+                    for (size_t j = 0; j < block; j++) out[j] = ops::cos(right[j]);
+                    break;
+                case INSTR_POW:
+                    for (size_t j = 0; j < block; j++) out[j] = ops::pow(left[j], right[j]);
+                    break;
+                case INSTR_POWI:
+                    for (size_t j = 0; j < block; j++) out[j] = reduced_pow_as(left[j], instruction -> value);
+                    break;
+                case INSTR_LN:
+                    for (size_t j = 0; j < block; j++)
+                        if (!ops::is_positive(right[j]))
+                            error = TREE_ERROR_YCHI_MATAN;
+                    for (size_t j = 0; j < block; j++) out[j] = ops::ln(right[j]);
+                    break;
+                case INSTR_EXP:
+                    for (size_t j = 0; j < block; j++) out[j] = ops::exp(right[j]);
+                    break;
+                default:
+                    error = TREE_ERROR_UNKNOWN_OPERATION;
+                    break;
+            }
+        }
+
+        const scalar_t* result_block = scratch + (size_t)expr -> result * BATCH_BLOCK_SIZE;
+        for (size_t j = 0; error == TREE_ERROR_NO && j < block; j++)
+            results[start + j] = result_block[j];
+    }
+
+    free(scratch);
+    return error;
+}
+
+#endif // TYPED_EVAL_H_
@@ -1,5 +1,7 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <assert.h>
 
 #include "user_interface.h"
@@ -15,6 +17,27 @@ const char* get_data_base_filename(int argc, const char** argv)
 }
 
 
+// Второй аргумент командной строки - порядок старшей производной
+tree_error_type get_number_of_derivatives(int argc, const char** argv, int* number_of_derivatives)
+{
+    assert(argv                  != NULL);
+    assert(number_of_derivatives != NULL);
+
+    *number_of_derivatives = DEFAULT_NUMBER_OF_DERIVATIVES;
+    if (argc < 3)
+        return TREE_ERROR_NO;
+
+    char* end   = NULL;
+    long  order = strtol(argv[2], &end, 10);
+
+    if (end == argv[2] || *end != '\0' || order < 1 || order > INT_MAX)
+        return TREE_ERROR_INVALID_INPUT;
+
+    *number_of_derivatives = (int)order;
+    return TREE_ERROR_NO;
+}
+
+
 const char* tree_error_translator(tree_error_type error)
 {
     switch (error)
@@ -38,6 +61,7 @@ const char* tree_error_translator(tree_error_type error)
         case TREE_ERROR_YCHI_MATAN:              return "Teach matan!";
         case TREE_ERROR_OPENING_FILE:            return "File opening error";
         case TREE_ERROR_VARIABLE_ALREADY_EXISTS: return "Error: The variable is already in the variable name table";
+        case TREE_ERROR_BUDGET_EXCEEDED:         return "The node or time budget was exceeded";
         default:                                 return "Unknown error";
     }
 }
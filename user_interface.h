@@ -6,6 +6,7 @@
 #include "tree_error_types.h"
 
 const char* get_data_base_filename(int argc, const char** argv);
+tree_error_type get_number_of_derivatives(int argc, const char** argv, int* number_of_derivatives);
 const char* tree_error_translator(tree_error_type error);
 char* select_differentiation_variable(variable_table* var_table);
 void print_tree_error(tree_error_type error);
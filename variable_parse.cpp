@@ -25,6 +25,7 @@ void init_variable_table(variable_table* ptr_table)
         ptr_table -> variables[index_of_variable].value      = 0.0;
         ptr_table -> variables[index_of_variable].hash       = 0;
         ptr_table -> variables[index_of_variable].is_defined = false;
+        ptr_table -> variables[index_of_variable].version    = 0;
     }
 }
 
@@ -108,6 +109,7 @@ tree_error_type add_variable(variable_table* ptr_table, const char* name_of_vari
     ptr_table -> variables[index].value = 0.0;
     ptr_table -> variables[index].hash = compute_hash(name_of_variable);
     ptr_table -> variables[index].is_defined = false;
+    ptr_table -> variables[index].version = 0;
 
     ptr_table -> number_of_variables++;
     ptr_table -> is_sorted = false;
@@ -126,6 +128,7 @@ tree_error_type set_variable_value(variable_table* ptr_table, const char* name_o
 
     ptr_table -> variables[index].value = value;
     ptr_table -> variables[index].is_defined = true;
+    ptr_table -> variables[index].version++;
 
     return TREE_ERROR_NO;
 }
@@ -16,6 +16,7 @@ struct variable_t
     size_t hash;
     double value;
     bool   is_defined;
+    size_t version;  // растёт при каждом set_variable_value
 };
 
 struct variable_table